@@ -0,0 +1,53 @@
+#include "Aggregate.h"
+#include "Table.h"
+
+/**
+ * @brief Adds a number.
+ * @param value The number.
+ */
+void Aggregate::add(const double value) {
+	this->sum += value;
+	this->min = value < this->min ? value : this->min;
+	this->max = value > this->max ? value : this->max;
+	this->count++;
+}
+
+/**
+ * @brief Adds the numeric value of a cell, if it has one.
+ * @details Strings count if they hold a number, formulas if their result is a number.
+ * @param cell The cell.
+ * @param table The table formulas read their cells from.
+ */
+void Aggregate::add(const Cell& cell, const Table& table) {
+	switch (cell.type) {
+	case INT:
+		this->add(cell.ival);
+		break;
+	case DOUBLE:
+		this->add(cell.dval);
+		break;
+	case STRING: {
+		if (cell.sval == nullptr) {
+			break;
+		}
+		Token token = Confirmer::classify(std::string_view(cell.sval, cell.size));
+		if (token.type == INT_TOKEN) {
+			this->add(token.ival);
+		}
+		else if (token.type == DOUBLE_TOKEN) {
+			this->add(token.dval);
+		}
+		break;
+	}
+	default: {
+		Value value = cell.fval->evaluate(table);
+		if (value.type == INT_VALUE) {
+			this->add(value.ival);
+		}
+		else if (value.type == DOUBLE_VALUE) {
+			this->add(value.dval);
+		}
+		break;
+	}
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <limits>
+#include "Cell.h"
+
+class Table;
+
+/**
+ * @struct Aggregate
+ * @brief The running sum, minimum, maximum and count of the numbers of a range.
+ *
+ * Numbers, numeric strings and the numeric results of formulas are counted, empty cells, other
+ * strings and failed formulas are skipped.
+ */
+struct Aggregate {
+	double sum = 0; /**< The sum of the numbers. */
+	double min = std::numeric_limits<double>::infinity(); /**< The smallest number. */
+	double max = -std::numeric_limits<double>::infinity(); /**< The biggest number. */
+	size_t count = 0; /**< The number of numbers. */
+
+	/**
+	 * @brief Adds a number.
+	 * @param value The number.
+	 */
+	void add(const double value);
+
+	/**
+	 * @brief Adds the numeric value of a cell, if it has one.
+	 * @param cell The cell.
+	 * @param table The table formulas read their cells from.
+	 */
+	void add(const Cell& cell, const Table& table);
+};
@@ -0,0 +1,122 @@
+#include "Arena.h"
+#include <new>
+
+/**
+ * @brief Default constructor for Arena.
+ * @details Initializes an arena without blocks, the first block is allocated on demand.
+ */
+Arena::Arena() : cursor(nullptr), end(nullptr) {
+	for (size_t i = 0; i < SIZE_CLASSES; i++) {
+		this->freeSlots[i] = nullptr;
+	}
+}
+
+/**
+ * @brief Allocates memory aligned to 16 bytes.
+ * @details A free slot of the same size class is reused first. Otherwise the memory is cut
+ * from the current block, and allocations larger than a quarter block get a block of their own.
+ * @param bytes The number of bytes to allocate.
+ * @return The allocated memory.
+ * @throws std::bad_alloc If a new block could not be allocated.
+ */
+void* Arena::allocate(const size_t bytes) {
+	size_t size = bytes == 0 ? GRANULE : (bytes + GRANULE - 1) / GRANULE * GRANULE;
+	size_t sizeClass = size / GRANULE - 1;
+	if (sizeClass < SIZE_CLASSES && this->freeSlots[sizeClass] != nullptr) {
+		FreeSlot* slot = this->freeSlots[sizeClass];
+		this->freeSlots[sizeClass] = slot->next;
+		return slot;
+	}
+	if (size > BLOCK_BYTES / 4) {
+		return this->addBlock(size);
+	}
+	if (static_cast<size_t>(this->end - this->cursor) < size) {
+		this->cursor = this->addBlock(BLOCK_BYTES);
+		this->end = this->cursor + BLOCK_BYTES;
+	}
+	void* memory = this->cursor;
+	this->cursor += size;
+	return memory;
+}
+
+/**
+ * @brief Gives memory back to the free list of its size class.
+ * @details Memory of allocations larger than the largest size class stays unused until the arena is released.
+ * @param memory The memory returned by allocate().
+ * @param bytes The number of bytes it was allocated with.
+ */
+void Arena::deallocate(void* memory, const size_t bytes) {
+	size_t size = bytes == 0 ? GRANULE : (bytes + GRANULE - 1) / GRANULE * GRANULE;
+	size_t sizeClass = size / GRANULE - 1;
+	if (memory == nullptr || sizeClass >= SIZE_CLASSES) {
+		return;
+	}
+	FreeSlot* slot = static_cast<FreeSlot*>(memory);
+	slot->next = this->freeSlots[sizeClass];
+	this->freeSlots[sizeClass] = slot;
+}
+
+/**
+ * @brief Takes over all blocks of another arena, which is left empty.
+ * @details Memory handed out by the other arena stays where it is and is now freed with this arena.
+ * The free lists of the other arena are dropped.
+ * @param other The arena to take the blocks from.
+ */
+void Arena::absorb(Arena& other) {
+	this->blocks.insert(this->blocks.end(), other.blocks.begin(), other.blocks.end());
+	this->blockSizes.insert(this->blockSizes.end(), other.blockSizes.begin(), other.blockSizes.end());
+	other.blocks.clear();
+	other.blockSizes.clear();
+	other.release();
+}
+
+/**
+ * @brief Frees all blocks at once.
+ */
+void Arena::release() {
+	for (size_t i = 0; i < this->blocks.size(); i++) {
+		::operator delete(this->blocks[i]);
+	}
+	this->blocks.clear();
+	this->blockSizes.clear();
+	this->cursor = nullptr;
+	this->end = nullptr;
+	for (size_t i = 0; i < SIZE_CLASSES; i++) {
+		this->freeSlots[i] = nullptr;
+	}
+}
+
+/**
+ * @brief Computes the memory held by the arena.
+ * @return The number of bytes of all blocks.
+ */
+size_t Arena::memoryUsage() const {
+	size_t bytes = 0;
+	for (size_t i = 0; i < this->blockSizes.size(); i++) {
+		bytes += this->blockSizes[i];
+	}
+	return bytes;
+}
+
+/**
+ * @brief Allocates a new block and records it.
+ * @details The block is recorded before it is allocated, so a failed allocation leaves nothing to free.
+ * @param size The size of the block.
+ * @return The block.
+ * @throws std::bad_alloc If the block could not be allocated.
+ */
+char* Arena::addBlock(const size_t size) {
+	this->blocks.push_back(nullptr);
+	this->blockSizes.push_back(0);
+	char* block = static_cast<char*>(::operator new(size));
+	this->blocks.back() = block;
+	this->blockSizes.back() = size;
+	return block;
+}
+
+/**
+ * @brief Destructor for Arena.
+ */
+Arena::~Arena() {
+	this->release();
+}
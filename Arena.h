@@ -0,0 +1,86 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+/**
+ * @class Arena
+ * @brief Hands out memory from large blocks that are all freed at once.
+ *
+ * Allocations are rounded up to 16 byte size classes and taken from the current block by
+ * moving a pointer. Memory given back with deallocate() is kept on the free list of its size
+ * class and reused by the next allocation of that class, it only returns to the system when
+ * the whole arena is released.
+ */
+class Arena {
+public:
+	/**
+	 * @brief Constructs an empty Arena object.
+	 */
+	Arena();
+
+	Arena(const Arena&) = delete; /**< Disable copy constructor. */
+	Arena& operator=(const Arena&) = delete; /**< Disable assignment operator. */
+
+	/**
+	 * @brief Allocates memory aligned to 16 bytes.
+	 * @param bytes The number of bytes to allocate.
+	 * @return The allocated memory.
+	 * @throws std::bad_alloc If a new block could not be allocated.
+	 */
+	void* allocate(const size_t bytes);
+
+	/**
+	 * @brief Gives memory back to the free list of its size class.
+	 * @param memory The memory returned by allocate().
+	 * @param bytes The number of bytes it was allocated with.
+	 */
+	void deallocate(void* memory, const size_t bytes);
+
+	/**
+	 * @brief Takes over all blocks of another arena, which is left empty.
+	 * @param other The arena to take the blocks from.
+	 */
+	void absorb(Arena& other);
+
+	/**
+	 * @brief Frees all blocks at once.
+	 */
+	void release();
+
+	/**
+	 * @brief Computes the memory held by the arena.
+	 * @return The number of bytes of all blocks.
+	 */
+	size_t memoryUsage() const;
+
+	/**
+	 * @brief Destructs the Arena object, freeing all blocks.
+	 */
+	~Arena();
+
+private:
+	/**
+	 * @struct FreeSlot
+	 * @brief A deallocated slot, linked into the free list of its size class.
+	 */
+	struct FreeSlot {
+		FreeSlot* next; /**< The next free slot of the same size class. */
+	};
+
+	/**
+	 * @brief Allocates a new block and records it.
+	 * @param size The size of the block.
+	 * @return The block.
+	 */
+	char* addBlock(const size_t size);
+
+	static const size_t GRANULE = 16; /**< The alignment and size step of all allocations. */
+	static const size_t SIZE_CLASSES = 16; /**< The number of size classes, larger allocations are not reused. */
+	static const size_t BLOCK_BYTES = 1 << 16; /**< The size of a regular block. */
+
+	std::vector<char*> blocks; /**< The allocated blocks. */
+	std::vector<size_t> blockSizes; /**< The size of every block. */
+	char* cursor; /**< The next free byte of the current block. */
+	char* end; /**< The end of the current block. */
+	FreeSlot* freeSlots[SIZE_CLASSES]; /**< The free list of every size class. */
+};
@@ -1,17 +1,35 @@
 #include"CSVReader.h"
+#include <cstring>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 /**
  * @brief Constructs a CSVReader object with the given filename and maximum token size.
  *
  * The constructor opens the specified CSV file and initializes the `maxTokens` member variable
- * with the provided maximum token size.
+ * with the provided maximum token size. In mapped mode the whole file is mapped into memory
+ * instead of being opened as a stream.
  *
  * @param filename The name of the CSV file to open.
  * @param maxSize The maximum size of tokens in the CSV file.
+ * @param mapped Whether the file should be memory-mapped.
  *
  * @throws std::ifstream::failure If the file fails to open.
  */
-CSVReader::CSVReader(const std::string& filename, int maxSize) : maxTokens(maxSize) {
+CSVReader::CSVReader(const std::string& filename, int maxSize, const bool mapped) : mapped(mapped), owned(true), mapping(nullptr), size(0),
+pos(0), good(false), maxTokens(maxSize), rows(0), bytes(0) {
+    if (mapped) {
+        this->map(filename);
+        return;
+    }
     try {
         in.open(filename);
         if (!in.is_open()) {
@@ -23,6 +41,18 @@ CSVReader::CSVReader(const std::string& filename, int maxSize) : maxTokens(maxSi
     }
 }
 
+/**
+ * @brief Constructs a CSVReader object that reads lines from memory.
+ *
+ * The reader works like a mapped reader but the memory is only borrowed, which lets several
+ * readers work on different chunks of the same mapped file.
+ *
+ * @param text The lines to read.
+ * @param maxSize The maximum size of tokens in the text.
+ */
+CSVReader::CSVReader(std::string_view text, int maxSize) : mapped(true), owned(false), mapping(text.data()), size(text.size()),
+pos(0), good(true), maxTokens(maxSize), rows(0), bytes(0) {}
+
 /**
  * @brief Checks if there is more data available to be read from the CSV file.
  *
@@ -32,6 +62,9 @@ CSVReader::CSVReader(const std::string& filename, int maxSize) : maxTokens(maxSi
  * @return True if there is more data available, False otherwise.
  */
 bool CSVReader::has_more_data() const{
+    if (this->mapped) {
+        return this->good;
+    }
     return in.good();
 }
 
@@ -46,31 +79,18 @@ bool CSVReader::has_more_data() const{
  * @return A vector of strings representing the tokens in the current line of the CSV file.
  */
 std::vector<std::string> CSVReader::get_tokens(){
+    if (this->mapped) {
+        const std::vector<std::string_view>& views = this->get_token_views();
+        return std::vector<std::string>(views.begin(), views.end());
+    }
     std::vector<std::string> tokens;
     std::string line;
     if (std::getline(in, line)) {
-        size_t i = 0;
-        while (i < line.size()) {
-            std::string token = "";
-            bool inText = false;
-            bool commaInside = false;
-            while (i < line.size() && line[i] != ',') {
-                if (inText) {
-                    token += line[i];
-                }
-                else {
-                    if (line[i] != ' ') {
-                        token += line[i];
-                    }
-                }
-                if ((line[i] == '"' && i == 0) || (line[i] == '"' && line[i - 1] != '\\')) {
-                    inText ? inText = false : inText = true;
-                }
-                i++;
-            }
-            tokens.push_back(token);
-            i++;
-        }
+        this->rows++;
+        this->bytes += line.size() + 1;
+        this->views.clear();
+        this->split(line);
+        tokens.assign(this->views.begin(), this->views.end());
     }
     if (tokens.size() < this->maxTokens) {
         while (tokens.size() < this->maxTokens) {
@@ -80,11 +100,205 @@ std::vector<std::string> CSVReader::get_tokens(){
     return tokens;
 }
 
+/**
+ * @brief Retrieves the tokens from the current line of the mapped CSV file without copying them.
+ *
+ * The tokens are split and cleaned exactly like get_tokens does. A token is returned as a slice of the
+ * mapping unless spaces outside of quotes have to be removed from it, in which case the cleaned token is
+ * written to a scratch buffer owned by the reader. The scratch buffer is sized for the whole line before
+ * any token is written, so neither the characters nor the tokens of a line cause allocations.
+ *
+ * @return Views of the tokens in the current line, valid until the next call.
+ */
+const std::vector<std::string_view>& CSVReader::get_token_views() {
+    this->views.clear();
+    std::string_view line;
+    if (this->mapped && this->next_line(line)) {
+        this->split(line);
+    }
+    while (this->views.size() < this->maxTokens) {
+        this->views.push_back(std::string_view());
+    }
+    return this->views;
+}
+
+/**
+ * @brief Splits a line into the token views of the reader.
+ *
+ * Every comma ends a token and spaces outside of quotes are removed, a quote preceded by a backslash
+ * does not open or close a quoted part. The line is scanned with CSVScanner.
+ *
+ * @param line The line to split.
+ */
+void CSVReader::split(std::string_view line) {
+    this->scratch.clear();
+    if (this->scratch.capacity() < line.size()) {
+        this->scratch.reserve(line.size());
+    }
+    this->scanner.scan(line, this->views, this->scratch);
+}
+
+/**
+ * @brief Reads the next line from the mapped file.
+ *
+ * Mirrors std::getline: the newline is consumed but not returned, and reaching the end of the
+ * file without a terminating newline leaves the reader without more data.
+ *
+ * @param line Receives a view of the line.
+ * @return `true` if a line was read, `false` if the end of the file was reached.
+ */
+bool CSVReader::next_line(std::string_view& line) {
+    if (!this->good || this->pos >= this->size) {
+        this->good = false;
+        return false;
+    }
+    const char* begin = this->mapping + this->pos;
+    const char* end = static_cast<const char*>(std::memchr(begin, '\n', this->size - this->pos));
+    if (end == nullptr) {
+        line = std::string_view(begin, this->size - this->pos);
+        this->pos = this->size;
+        this->good = false;
+    }
+    else {
+        line = std::string_view(begin, end - begin);
+        this->pos += line.size() + 1;
+    }
+    this->rows++;
+    this->bytes += line.size() + 1;
+    return true;
+}
+
+/**
+ * @brief Maps the whole CSV file into memory for reading.
+ *
+ * An empty file is not mapped at all, it simply has no lines to read.
+ *
+ * @param filename The name of the CSV file to map.
+ *
+ * @throws std::ifstream::failure If the file fails to open or to map.
+ */
+void CSVReader::map(const std::string& filename) {
+    try {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::ifstream::failure("File didnt open");
+        }
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(file, &fileSize);
+        this->size = static_cast<size_t>(fileSize.QuadPart);
+        if (this->size > 0) {
+            HANDLE mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            CloseHandle(file);
+            if (mappingHandle == nullptr) {
+                throw std::ifstream::failure("File didnt map");
+            }
+            this->mapping = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+            CloseHandle(mappingHandle);
+            if (this->mapping == nullptr) {
+                throw std::ifstream::failure("File didnt map");
+            }
+        }
+        else CloseHandle(file);
+#else
+        int file = open(filename.c_str(), O_RDONLY);
+        if (file < 0) {
+            throw std::ifstream::failure("File didnt open");
+        }
+        struct stat info;
+        if (fstat(file, &info) != 0) {
+            close(file);
+            throw std::ifstream::failure("File didnt open");
+        }
+        this->size = static_cast<size_t>(info.st_size);
+        if (this->size > 0) {
+            void* address = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, file, 0);
+            close(file);
+            if (address == MAP_FAILED) {
+                throw std::ifstream::failure("File didnt map");
+            }
+            madvise(address, this->size, MADV_SEQUENTIAL);
+            this->mapping = static_cast<const char*>(address);
+        }
+        else close(file);
+#endif
+        this->good = true;
+    }
+    catch (const std::ifstream::failure& e) {
+        this->size = 0;
+        std::cout << e.what();
+    }
+}
+
+/**
+ * @brief Releases the memory mapping of the CSV file, if there is one.
+ */
+void CSVReader::unmap() {
+    if (this->mapping == nullptr || !this->owned) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(this->mapping);
+#else
+    munmap(const_cast<char*>(this->mapping), this->size);
+#endif
+    this->mapping = nullptr;
+}
+
+/**
+ * @brief Splits the unread part of a mapped file into chunks that end on line boundaries.
+ *
+ * The chunks are about the same size, each one except the last ends right after a newline.
+ * A line never continues past its newline, not even inside quotes, so no token is ever split
+ * between two chunks. The last chunk may be empty, reading it then yields the same final row
+ * as reading past the last newline of the file.
+ *
+ * @param count The number of chunks wanted.
+ * @return The chunks, in file order.
+ */
+std::vector<std::string_view> CSVReader::get_chunks(const size_t count) const {
+    std::vector<std::string_view> chunks;
+    size_t begin = this->pos;
+    while (begin < this->size && chunks.size() + 1 < count) {
+        size_t target = begin + (this->size - begin) / (count - chunks.size());
+        const char* newline = static_cast<const char*>(std::memchr(this->mapping + target, '\n', this->size - target));
+        if (newline == nullptr) {
+            break;
+        }
+        size_t end = newline - this->mapping + 1;
+        chunks.push_back(std::string_view(this->mapping + begin, end - begin));
+        begin = end;
+    }
+    chunks.push_back(std::string_view(this->mapping + begin, this->size - begin));
+    return chunks;
+}
+
+/**
+ * @brief Retrieves the number of lines read from the CSV file so far.
+ *
+ * @return The number of lines successfully read by get_tokens.
+ */
+size_t CSVReader::rows_read() const {
+    return this->rows;
+}
+
+/**
+ * @brief Retrieves the number of bytes read from the CSV file so far.
+ *
+ * Every line is counted together with its terminating newline.
+ *
+ * @return The number of bytes consumed by get_tokens.
+ */
+size_t CSVReader::bytes_read() const {
+    return this->bytes;
+}
+
 /**
  * @brief Destructor for the CSVReader class.
  *
- * The destructor closes the input file stream associated with the CSVReader object.
+ * The destructor closes the input file stream or releases the mapping associated with the CSVReader object.
  */
 CSVReader::~CSVReader() {
+    this->unmap();
     this->in.close();
 }
\ No newline at end of file
@@ -1,7 +1,10 @@
+#pragma once
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <vector>
+#include <string_view>
+#include "CSVScanner.h"
 
 /**
  * @class CSVReader
@@ -12,9 +15,18 @@ public:
     /**
      * @brief Constructs a CSVReader object.
      * @param filename The name of the CSV file to read.
-     * @param maxTokens The maximum number of tokens row has.
+     * @param maxTokens The maximum number of tokens row has, 0 disables padding.
+     * @param mapped If `true` the file is memory-mapped instead of read through a stream.
      */
-    CSVReader(const std::string& filename, const int maxTokens);
+    CSVReader(const std::string& filename, const int maxTokens, const bool mapped = false);
+
+    /**
+     * @brief Constructs a CSVReader object over text that is already in memory.
+     * @param text The lines to read, they must outlive the reader.
+     * @param maxTokens The maximum number of tokens row has, 0 disables padding.
+     * @note The reader behaves like a mapped reader of a file holding exactly `text`.
+     */
+    CSVReader(std::string_view text, const int maxTokens);
 
     /**
      * @brief Checks if there is more data to be read from the CSV file.
@@ -28,12 +40,73 @@ public:
      */
     std::vector<std::string> get_tokens();
 
+    /**
+     * @brief Retrieves the tokens of the next line without copying them.
+     * @return Views of the tokens in the line, valid until the next call.
+     * @note Only available when the reader was created in mapped mode.
+     */
+    const std::vector<std::string_view>& get_token_views();
+
+    /**
+     * @brief Splits the unread part of a mapped file into chunks of whole lines.
+     * @param count The number of chunks wanted.
+     * @return At most `count` consecutive chunks covering the unread part of the file.
+     */
+    std::vector<std::string_view> get_chunks(const size_t count) const;
+
+    /**
+     * @brief Retrieves the number of lines read from the CSV file so far.
+     * @return The number of lines read.
+     */
+    size_t rows_read() const;
+
+    /**
+     * @brief Retrieves the number of bytes read from the CSV file so far.
+     * @return The number of bytes read, line terminators included.
+     */
+    size_t bytes_read() const;
+
     /**
      * @brief Destructs the CSVReader object.
      */
     ~CSVReader();
 
 private:
+    /**
+     * @brief Maps the whole file into memory.
+     * @param filename The name of the CSV file to map.
+     */
+    void map(const std::string& filename);
+
+    /**
+     * @brief Releases the memory mapping of the file.
+     */
+    void unmap();
+
+    /**
+     * @brief Splits a line into the token views of the reader.
+     * @param line The line to split.
+     */
+    void split(std::string_view line);
+
+    /**
+     * @brief Reads the next line from the mapping, the same way std::getline would.
+     * @param line Receives a view of the line without its terminating newline.
+     * @return `true` if a line was read, `false` otherwise.
+     */
+    bool next_line(std::string_view& line);
+
     std::ifstream in; /**< The input file stream used for reading the CSV file. */
+    bool mapped; /**< Whether the file is memory-mapped. */
+    bool owned; /**< Whether the mapping belongs to the reader. */
+    const char* mapping; /**< The first byte of the mapped file. */
+    size_t size; /**< The size of the mapped file. */
+    size_t pos; /**< The offset of the next unread byte in the mapping. */
+    bool good; /**< The stream-like state of the mapped reader. */
+    std::vector<std::string_view> views; /**< The token views of the last line read. */
+    std::string scratch; /**< Holds the tokens which needed spaces removed. */
+    CSVScanner scanner; /**< Finds the token boundaries of a line. */
     size_t maxTokens; /**< The maximum number of tokens to parse per line. */
+    size_t rows; /**< The number of lines read so far. */
+    size_t bytes; /**< The number of bytes read so far. */
 };
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "CSVScanner.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(CSV_SCANNER_SCALAR)
+// The scalar classification was requested, for testing it on a machine with SIMD.
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define CSV_SCANNER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CSV_SCANNER_SSE2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * @brief Counts the trailing zero bits of a non-zero mask.
+ * @param mask The mask to inspect.
+ * @return The index of the lowest set bit.
+ */
+static inline unsigned lowestBit(const uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+/**
+ * @brief Computes the running parity of a mask, bit i is the xor of bits 0..i.
+ * @param mask The mask to process.
+ * @return The prefix xor of the mask.
+ */
+static inline uint32_t prefixXor(uint32_t mask) {
+    mask ^= mask << 1;
+    mask ^= mask << 2;
+    mask ^= mask << 4;
+    mask ^= mask << 8;
+    mask ^= mask << 16;
+    return mask;
+}
+
+/**
+ * @brief Builds a mask with the bits in [from, to) set.
+ * @param from The first bit of the range.
+ * @param to One past the last bit of the range, at most 32.
+ * @return The mask of the range.
+ */
+static inline uint32_t bitRange(const unsigned from, const unsigned to) {
+    uint32_t upper = to >= 32 ? ~0u : (1u << to) - 1;
+    uint32_t lower = from >= 32 ? 0u : ~0u << from;
+    return upper & lower;
+}
+
+/**
+ * @brief Finds the commas, quotes, spaces and backslashes of a 32 byte block.
+ *
+ * @param block The block to classify.
+ * @return One mask per character class, bit i standing for byte i of the block.
+ */
+CSVScanner::Masks CSVScanner::classify(const char* block) {
+    Masks masks;
+#if defined(CSV_SCANNER_AVX2)
+    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    masks.comma = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(','))));
+    masks.quote = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"'))));
+    masks.space = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' '))));
+    masks.slash = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\'))));
+#elif defined(CSV_SCANNER_SSE2)
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16));
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i slash = _mm_set1_epi8('\\');
+    masks.comma = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(low, comma))) |
+        static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(high, comma))) << 16;
+    masks.quote = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(low, quote))) |
+        static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(high, quote))) << 16;
+    masks.space = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(low, space))) |
+        static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(high, space))) << 16;
+    masks.slash = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(low, slash))) |
+        static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(high, slash))) << 16;
+#else
+    masks.comma = masks.quote = masks.space = masks.slash = 0;
+    for (unsigned i = 0; i < 32; i++) {
+        uint32_t bit = 1u << i;
+        switch (block[i]) {
+        case ',': masks.comma |= bit; break;
+        case '"': masks.quote |= bit; break;
+        case ' ': masks.space |= bit; break;
+        case '\\': masks.slash |= bit; break;
+        default: break;
+        }
+    }
+#endif
+    return masks;
+}
+
+/**
+ * @brief Splits a line into tokens.
+ *
+ * The first pass classifies the line block by block. A quote toggles the quoted state unless it
+ * follows a backslash, and the state is reset at every comma, so the quoted regions of a block are
+ * the running parity of its toggling quotes restarted at each comma. The spaces outside of those
+ * regions are recorded as the characters to drop. The second pass walks the comma bits to find the
+ * token boundaries. A token without spaces to drop is returned as a slice of the line, the others
+ * are copied to the scratch buffer one run of kept characters at a time.
+ *
+ * @param line The line to split.
+ * @param tokens Receives the tokens of the line.
+ * @param scratch Holds the tokens that needed spaces removed.
+ */
+void CSVScanner::scan(std::string_view line, std::vector<std::string_view>& tokens, std::string& scratch) {
+    size_t blocks = (line.size() + 31) / 32;
+    this->commas.resize(blocks);
+    this->drops.resize(blocks);
+
+    uint32_t escaped = 0;
+    uint32_t parityCarry = 0;
+    uint32_t base = 0;
+    char tail[32];
+    for (size_t k = 0; k < blocks; k++) {
+        size_t offset = k * 32;
+        const char* block = line.data() + offset;
+        if (line.size() - offset < 32) {
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, block, line.size() - offset);
+            block = tail;
+        }
+        Masks masks = classify(block);
+
+        uint32_t toggles = masks.quote & ~((masks.slash << 1) | escaped);
+        uint32_t parity = prefixXor(toggles) ^ parityCarry;
+        uint32_t quoted = 0;
+        uint32_t rest = masks.comma;
+        unsigned from = 0;
+        while (true) {
+            unsigned to = rest ? lowestBit(rest) : 32;
+            quoted |= (parity ^ base) & bitRange(from, to);
+            if (!rest) {
+                break;
+            }
+            base = (parity >> to) & 1 ? ~0u : 0u;
+            from = to + 1;
+            rest &= rest - 1;
+        }
+
+        this->commas[k] = masks.comma;
+        this->drops[k] = masks.space & ~quoted;
+        escaped = masks.slash >> 31;
+        parityCarry = parity >> 31 ? ~0u : 0u;
+    }
+
+    size_t start = 0;
+    for (size_t k = 0; k < blocks; k++) {
+        uint32_t rest = this->commas[k];
+        while (rest) {
+            size_t comma = k * 32 + lowestBit(rest);
+            this->emit(line, start, comma, tokens, scratch);
+            start = comma + 1;
+            rest &= rest - 1;
+        }
+    }
+    if (start < line.size()) {
+        this->emit(line, start, line.size(), tokens, scratch);
+    }
+}
+
+/**
+ * @brief Emits a single token of the line.
+ *
+ * @param line The line being split.
+ * @param begin The offset of the first character of the token.
+ * @param end The offset one past the last character of the token.
+ * @param tokens Receives the token.
+ * @param scratch Holds the token if spaces have to be removed from it.
+ */
+void CSVScanner::emit(std::string_view line, size_t begin, size_t end, std::vector<std::string_view>& tokens, std::string& scratch) const {
+    size_t drop = this->nextDrop(begin, end);
+    if (drop == end) {
+        tokens.push_back(line.substr(begin, end - begin));
+        return;
+    }
+    size_t from = scratch.size();
+    size_t pos = begin;
+    while (pos < end) {
+        scratch.append(line.data() + pos, drop - pos);
+        pos = drop + 1;
+        drop = this->nextDrop(pos, end);
+    }
+    tokens.push_back(std::string_view(scratch.data() + from, scratch.size() - from));
+}
+
+/**
+ * @brief Finds the next space to drop in a range of the line.
+ *
+ * @param from The offset to start searching at.
+ * @param end The offset to stop searching at.
+ * @return The offset of the next space to drop, or `end` if there is none.
+ */
+size_t CSVScanner::nextDrop(size_t from, size_t end) const {
+    while (from < end) {
+        size_t k = from / 32;
+        uint32_t word = this->drops[k] & (~0u << (from % 32));
+        if (word) {
+            return std::min(k * 32 + lowestBit(word), end);
+        }
+        from = (k + 1) * 32;
+    }
+    return end;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @class CSVScanner
+ * @brief Splits CSV lines into tokens by scanning them 32 bytes at a time.
+ *
+ * The delimiter, quote, escape and space positions of a block are found with SIMD compares
+ * (AVX2 or SSE2 when the compiler targets them, a scalar loop otherwise or when
+ * CSV_SCANNER_SCALAR is defined) and the tokens are built from the resulting bitmasks. The
+ * tokens are the same as the ones produced by the character by character parser of CSVReader:
+ * every comma ends a token and spaces outside of quotes are removed.
+ */
+class CSVScanner {
+public:
+    /**
+     * @brief Splits a line into tokens.
+     * @param line The line to split, without its terminating newline.
+     * @param tokens Receives the tokens of the line.
+     * @param scratch Holds the tokens that needed spaces removed, its capacity must be at least the size of the line.
+     */
+    void scan(std::string_view line, std::vector<std::string_view>& tokens, std::string& scratch);
+
+private:
+    /**
+     * @struct Masks
+     * @brief The positions of the interesting characters of a 32 byte block, one bit per byte.
+     */
+    struct Masks {
+        uint32_t comma; /**< Bits of the ',' characters. */
+        uint32_t quote; /**< Bits of the '"' characters. */
+        uint32_t space; /**< Bits of the ' ' characters. */
+        uint32_t slash; /**< Bits of the '\\' characters. */
+    };
+
+    /**
+     * @brief Finds the interesting characters of a block.
+     * @param block The block to classify, 32 readable bytes.
+     * @return The masks of the block.
+     */
+    static Masks classify(const char* block);
+
+    /**
+     * @brief Emits the token between two offsets of the line.
+     * @param line The line being split.
+     * @param begin The offset of the first character of the token.
+     * @param end The offset one past the last character of the token.
+     * @param tokens Receives the token.
+     * @param scratch Holds the token if spaces have to be removed from it.
+     */
+    void emit(std::string_view line, size_t begin, size_t end, std::vector<std::string_view>& tokens, std::string& scratch) const;
+
+    /**
+     * @brief Finds the next removed space of the line.
+     * @param from The offset to start searching at.
+     * @param end The offset to stop searching at.
+     * @return The offset of the next removed space, or `end` if there is none.
+     */
+    size_t nextDrop(size_t from, size_t end) const;
+
+    std::vector<uint32_t> commas; /**< The comma bits of the current line. */
+    std::vector<uint32_t> drops; /**< The bits of the spaces outside quotes of the current line. */
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include "Data.h"
+
+class FormulaData;
+
+/**
+ * @struct Cell
+ * @brief A compact, type-tagged value of a single table cell.
+ *
+ * Numbers are stored inline, the characters of strings and formulas are stored in the
+ * arena of the CellStore that owns the cell and referenced from here.
+ */
+struct Cell {
+	union {
+		int ival; /**< The value of an INT cell. */
+		double dval; /**< The value of a DOUBLE cell. */
+		const char* sval; /**< The characters of a STRING cell, `nullptr` for an empty string. */
+		FormulaData* fval; /**< The formula of a FORMULA cell. */
+	};
+	DataType type; /**< The type of the value. */
+	unsigned size; /**< The number of characters of a STRING cell. */
+};
+
+static_assert(sizeof(Cell) == 16, "A cell must fit in a 16 byte slot");
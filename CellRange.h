@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * @struct CellRange
+ * @brief A rectangle of cells, given by its first and last row and column.
+ */
+struct CellRange {
+	int top = 0; /**< The first row of the range. */
+	int left = 0; /**< The first column of the range. */
+	int bottom = 0; /**< The last row of the range. */
+	int right = 0; /**< The last column of the range. */
+};
@@ -0,0 +1,574 @@
+#include "CellStore.h"
+#include "FormulaParser.h"
+#include "SnapshotRecord.h"
+#include <climits>
+#include <algorithm>
+#include <unordered_set>
+#include <unordered_map>
+#include <sstream>
+#include <new>
+#include <utility>
+
+/**
+ * @brief Converts an instruction to its layout in a snapshot.
+ * @param instruction The instruction.
+ * @return The stored instruction.
+ */
+static StoredInstruction storeInstruction(const Instruction& instruction) {
+	StoredInstruction stored;
+	stored.op = static_cast<uint32_t>(instruction.op);
+	stored.row = instruction.row;
+	stored.col = instruction.col;
+	stored.top = instruction.range.top;
+	stored.left = instruction.range.left;
+	stored.bottom = instruction.range.bottom;
+	stored.right = instruction.range.right;
+	stored.number = instruction.number;
+	return stored;
+}
+
+/**
+ * @brief Converts instructions read from a snapshot and checks that they form one complete expression.
+ * @details Evaluation trusts the instructions it is given, so every operation must be known and
+ * find its operands on the stack, and every range must have its corners in order. The operation
+ * is checked as an integer before it becomes an OpCode.
+ * @param stored The instructions as they are stored, in postfix order.
+ * @param code Receives the instructions.
+ * @return `true` if the instructions leave exactly one value, or are empty, `false` otherwise.
+ */
+static bool loadCode(const std::vector<StoredInstruction>& stored, std::vector<Instruction>& code) {
+	size_t depth = 0;
+	code.resize(stored.size());
+	for (size_t i = 0; i < stored.size(); i++) {
+		if (stored[i].op > static_cast<uint32_t>(OP_COUNT)) {
+			return false;
+		}
+		Instruction& instruction = code[i];
+		instruction.op = static_cast<OpCode>(stored[i].op);
+		instruction.row = stored[i].row;
+		instruction.col = stored[i].col;
+		instruction.range.top = stored[i].top;
+		instruction.range.left = stored[i].left;
+		instruction.range.bottom = stored[i].bottom;
+		instruction.range.right = stored[i].right;
+		instruction.number = stored[i].number;
+		if (instruction.op >= OP_SUM && (instruction.range.top < 0 || instruction.range.left < 0
+			|| instruction.range.top > instruction.range.bottom || instruction.range.left > instruction.range.right)) {
+			return false;
+		}
+		if (FormulaParser::precedence(instruction.op) == FormulaParser::OPERAND) {
+			depth++;
+		}
+		else if (depth < (instruction.op == OP_NEGATE ? 1u : 2u)) {
+			return false;
+		}
+		else if (instruction.op != OP_NEGATE) {
+			depth--;
+		}
+	}
+	return code.empty() || depth == 1;
+}
+
+/**
+ * @brief Default constructor for CellStore.
+ * @details Initializes an empty store without rows.
+ */
+CellStore::CellStore() : rows(0), cols(0) {}
+
+/**
+ * @brief Retrieves a cell of a padded store.
+ * @param row The row index of the cell.
+ * @param col The column index of the cell.
+ * @return The cell.
+ */
+Cell CellStore::at(const size_t row, const size_t col) const {
+	if (!this->columns.empty()) {
+		return this->columns[col].get(row);
+	}
+	return this->cells[row * this->cols + col];
+}
+
+/**
+ * @brief Retrieves a cell of a padded store through the Data interface.
+ * @param row The row index of the cell.
+ * @param col The column index of the cell.
+ * @return A view of the cell.
+ */
+CellView CellStore::view(const size_t row, const size_t col) const {
+	return CellView(this->at(row, col));
+}
+
+/**
+ * @brief Retrieves the number of rows in the store.
+ * @return The number of rows.
+ */
+size_t CellStore::getRows() const {
+	return this->rows;
+}
+
+/**
+ * @brief Retrieves the number of columns of a padded store.
+ * @return The number of columns.
+ */
+size_t CellStore::getCols() const {
+	return this->cols;
+}
+
+/**
+ * @brief Starts a new, empty row at the end of the store.
+ */
+void CellStore::addRow() {
+	this->rowStart.push_back(this->cells.size());
+	this->rows++;
+}
+
+/**
+ * @brief Appends a cell to the last row of the store.
+ * @param token The classified token holding the value of the cell.
+ */
+void CellStore::add(Token& token) {
+	this->cells.push_back(this->make(token, this->rows - 1, this->cells.size() - this->rowStart.back()));
+}
+
+/**
+ * @brief Replaces a cell of a padded store.
+ * @details The string of the old value is released and the arena memory of an old formula is reused by later cells.
+ * @param row The row index of the cell.
+ * @param col The column index of the cell.
+ * @param token The classified token holding the new value of the cell.
+ */
+void CellStore::set(const size_t row, const size_t col, Token& token) {
+	Cell cell = this->make(token, row, col);
+	if (!this->columns.empty()) {
+		this->release(this->columns[col].get(row));
+		this->columns[col].set(row, cell);
+		return;
+	}
+	Cell& slot = this->cells[row * this->cols + col];
+	this->release(slot);
+	slot = cell;
+}
+
+/**
+ * @brief Gives every row the same number of cells.
+ *
+ * The rows are moved to their final place in the same array, starting from the last row so that
+ * no row is overwritten before it is moved. The cells added to short rows are empty strings.
+ *
+ * @param width The number of cells of every row.
+ */
+void CellStore::pad(const size_t width) {
+	Cell empty = {};
+	empty.sval = nullptr;
+	empty.type = STRING;
+	size_t used = this->cells.size();
+	this->cells.resize(this->rows * width, empty);
+	for (size_t row = this->rows; row-- > 0;) {
+		size_t begin = this->rowStart[row];
+		size_t end = row + 1 < this->rows ? this->rowStart[row + 1] : used;
+		auto target = this->cells.begin() + row * width;
+		std::copy_backward(this->cells.begin() + begin, this->cells.begin() + end, target + (end - begin));
+		std::fill(target + (end - begin), target + width, empty);
+	}
+	this->cols = width;
+	this->rowStart.clear();
+	this->rowStart.shrink_to_fit();
+}
+
+/**
+ * @brief Converts a padded store to one typed column per table column.
+ * @details The row-major array is freed once every column is built.
+ */
+void CellStore::columnize() {
+	if (!this->columns.empty() || this->rows == 0) {
+		return;
+	}
+	this->columns.reserve(this->cols);
+	for (size_t col = 0; col < this->cols; col++) {
+		this->columns.emplace_back(this->cells.data() + col, this->rows, this->cols);
+	}
+	std::vector<Cell>().swap(this->cells);
+}
+
+/**
+ * @brief Computes the length of the longest string representation in a column of a padded store.
+ * @param col The column index.
+ * @return The length of the longest string representation.
+ */
+size_t CellStore::width(const size_t col) const {
+	if (!this->columns.empty()) {
+		return this->columns[col].width();
+	}
+	size_t widest = 0;
+	for (size_t row = 0; row < this->rows; row++) {
+		widest = std::max(widest, this->view(row, col).format(nullptr, 0));
+	}
+	return widest;
+}
+
+/**
+ * @brief Adds the numbers of a range of a padded store to an aggregate.
+ * @details Columnized stores hand every column to its own kernel, otherwise the cells are added one by one.
+ * @param range The range, it must lie inside the store.
+ * @param total The aggregate to add to.
+ * @param table The table formulas read their cells from.
+ */
+void CellStore::aggregate(const CellRange& range, Aggregate& total, const Table& table) const {
+	for (size_t col = range.left; col <= static_cast<size_t>(range.right); col++) {
+		if (!this->columns.empty()) {
+			this->columns[col].aggregate(range.top, range.bottom + 1, total, table);
+			continue;
+		}
+		for (size_t row = range.top; row <= static_cast<size_t>(range.bottom); row++) {
+			total.add(this->cells[row * this->cols + col], table);
+		}
+	}
+}
+
+/**
+ * @brief Moves all rows of another store to the end of this one.
+ * @details The arena blocks of the other store are taken over, so formulas stay where they
+ * are. Strings are interned again in the pool of this store. The formulas move down by the rows
+ * already in this store, every expression of the other store is rebased and interned once and
+ * the formulas sharing it only add a reference.
+ * @param other The store to take the rows from, it must not be columnized.
+ */
+void CellStore::append(CellStore& other) {
+	size_t offset = this->cells.size();
+	int moved = static_cast<int>(this->rows);
+	std::unordered_map<const Expression*, const Expression*> rebased;
+	this->rowStart.reserve(this->rowStart.size() + other.rows);
+	for (size_t row = 0; row < other.rows; row++) {
+		this->rowStart.push_back(offset + (other.cols ? row * other.cols : other.rowStart[row]));
+	}
+	this->rows += other.rows;
+	this->cells.insert(this->cells.end(), other.cells.begin(), other.cells.end());
+	for (size_t i = offset; i < this->cells.size(); i++) {
+		Cell& cell = this->cells[i];
+		if (cell.type == STRING && cell.sval != nullptr) {
+			cell.sval = this->strings.intern(std::string_view(cell.sval, cell.size)).data();
+		}
+		else if (cell.type == FORMULA) {
+			const Expression* expression = cell.fval->getExpression();
+			auto found = rebased.find(expression);
+			if (found != rebased.end()) {
+				this->expressions.retain(found->second);
+			}
+			else {
+				std::vector<Instruction> code = expression->code;
+				FormulaData::makeRelative(code, moved, 0);
+				found = rebased.emplace(expression, this->expressions.intern(std::move(code))).first;
+			}
+			cell.fval->moveDown(found->second, moved);
+		}
+	}
+	this->arena.absorb(other.arena);
+	other.cells.clear();
+	other.clear();
+}
+
+/**
+ * @brief Removes all cells from the store.
+ * @details The formulas are destroyed, then the arena and the string and expression pools are released in one go.
+ */
+void CellStore::clear() {
+	this->destroyFormulas();
+	this->cells.clear();
+	this->columns.clear();
+	this->rowStart.clear();
+	this->rows = 0;
+	this->cols = 0;
+	this->arena.release();
+	this->strings.clear();
+	this->expressions.clear();
+}
+
+/**
+ * @brief Computes the memory used by the store.
+ * @details Counts the cell array, the columns, the string and expression pools and the arena blocks.
+ * @return The number of bytes used.
+ */
+size_t CellStore::memoryUsage() const {
+	size_t bytes = this->cells.capacity() * sizeof(Cell) + this->rowStart.capacity() * sizeof(size_t);
+	for (size_t i = 0; i < this->columns.size(); i++) {
+		bytes += sizeof(Column) + this->columns[i].memoryUsage();
+	}
+	return bytes + this->strings.memoryUsage() + this->expressions.memoryUsage() + this->arena.memoryUsage();
+}
+
+/**
+ * @brief Describes how much interning saves in every column that holds strings.
+ * @details Interned strings are equal exactly when their data pointers are, so the distinct
+ * strings of a column are counted by pointer.
+ * @return One line per column with its string cells, distinct strings, dedup ratio and bytes saved.
+ */
+std::string CellStore::stringReport() const {
+	std::ostringstream report;
+	std::unordered_set<const char*> distinct;
+	for (size_t col = 0; col < this->cols; col++) {
+		size_t count = 0;
+		size_t bytes = 0;
+		size_t distinctBytes = 0;
+		distinct.clear();
+		for (size_t row = 0; row < this->rows; row++) {
+			Cell cell = this->at(row, col);
+			if (cell.type != STRING || cell.sval == nullptr) {
+				continue;
+			}
+			count++;
+			bytes += cell.size;
+			if (distinct.insert(cell.sval).second) {
+				distinctBytes += cell.size;
+			}
+		}
+		if (count > 0) {
+			report << "Column " << col << ": " << count << " strings, " << distinct.size() << " distinct ("
+				<< static_cast<double>(count) / distinct.size() << "x), " << bytes - distinctBytes << " bytes saved\n";
+		}
+	}
+	return report.str();
+}
+
+/**
+ * @brief Writes a padded store to a snapshot.
+ * @details The snapshot holds the size of the store, then the string dictionary: the length of every
+ * interned string, followed by all their characters. Then comes the
+ * expression pool: the length of every expression, followed by all their instructions, with the
+ * cell references relative as they are stored. Last comes one block per column, written by
+ * Column::writeSnapshot(). A store that is not columnized is written through temporary columns.
+ * @param out The snapshot.
+ */
+void CellStore::writeSnapshot(SnapshotWriter& out) const {
+	out.writeValue<uint64_t>(this->rows);
+	out.writeValue<uint64_t>(this->cols);
+
+	std::vector<std::string_view> entries = this->strings.entries();
+	std::unordered_map<const char*, uint32_t> index;
+	std::vector<uint32_t> lengths(entries.size());
+	index.reserve(entries.size());
+	for (size_t i = 0; i < entries.size(); i++) {
+		index.emplace(entries[i].data(), static_cast<uint32_t>(i));
+		lengths[i] = static_cast<uint32_t>(entries[i].size());
+	}
+	out.writeValue<uint64_t>(entries.size());
+	out.writeArray(lengths);
+	for (size_t i = 0; i < entries.size(); i++) {
+		out.writeBytes(entries[i].data(), entries[i].size());
+	}
+
+	lengths.resize(this->expressions.size());
+	for (size_t i = 0; i < lengths.size(); i++) {
+		lengths[i] = static_cast<uint32_t>(this->expressions.get(i)->code.size());
+	}
+	out.writeValue<uint64_t>(lengths.size());
+	out.writeArray(lengths);
+	std::vector<StoredInstruction> stored;
+	for (size_t i = 0; i < lengths.size(); i++) {
+		const std::vector<Instruction>& code = this->expressions.get(i)->code;
+		stored.resize(code.size());
+		for (size_t j = 0; j < code.size(); j++) {
+			stored[j] = storeInstruction(code[j]);
+		}
+		out.writeArray(stored);
+	}
+
+	for (size_t col = 0; col < this->cols; col++) {
+		if (!this->columns.empty()) {
+			this->columns[col].writeSnapshot(out, index);
+		}
+		else {
+			Column(this->cells.data() + col, this->rows, this->cols).writeSnapshot(out, index);
+		}
+	}
+}
+
+/**
+ * @brief Replaces the cells of the store with the ones of a snapshot.
+ * @details The expressions are interned once each, then the columns are read block by block. A
+ * string of the dictionary is interned the first time a cell uses it, so the entries no cell uses
+ * never reach the pool. A formula is created in the arena with its saved result, so nothing is
+ * parsed or evaluated. The references to every string are counted while the columns are read and
+ * added at once at the end. Every length and index is checked against the snapshot before it is used, and
+ * the store is columnized afterwards.
+ * @param in The snapshot, at the part written by writeSnapshot().
+ * @return `true` if the snapshot was valid, `false` otherwise, the store is then empty.
+ * @throws std::bad_alloc If there is not enough memory, the store must then be cleared.
+ */
+bool CellStore::readSnapshot(SnapshotReader& in) {
+	this->clear();
+	uint64_t rows = in.readValue<uint64_t>();
+	uint64_t cols = in.readValue<uint64_t>();
+	if (rows > INT_MAX || cols > INT_MAX) {
+		in.fail();
+	}
+
+	std::vector<uint32_t> lengths;
+	std::vector<char> text;
+	uint64_t count = in.readValue<uint64_t>();
+	in.readArray(lengths, count);
+	uint64_t total = 0;
+	for (size_t i = 0; i < lengths.size(); i++) {
+		total += lengths[i];
+	}
+	in.readArray(text, total);
+	std::vector<std::string_view> views(in.good() ? count : 0);
+	std::vector<std::string_view> interned(views.size());
+	std::vector<size_t> uses(views.size(), 0);
+	size_t offset = 0;
+	for (size_t i = 0; i < views.size(); i++) {
+		if (lengths[i] == 0) {
+			in.fail();
+			break;
+		}
+		views[i] = std::string_view(text.data() + offset, lengths[i]);
+		offset += lengths[i];
+	}
+
+	std::vector<const Expression*> loaded;
+	count = in.readValue<uint64_t>();
+	in.readArray(lengths, count);
+	std::vector<StoredInstruction> stored;
+	for (size_t i = 0; i < lengths.size() && in.good(); i++) {
+		std::vector<Instruction> code;
+		if (in.readArray(stored, lengths[i]) && !loadCode(stored, code)) {
+			in.fail();
+		}
+		if (in.good()) {
+			loaded.push_back(this->expressions.intern(std::move(code)));
+		}
+	}
+
+	this->rows = in.good() ? rows : 0;
+	this->cols = in.good() ? cols : 0;
+	auto string = [&](const uint64_t index) -> std::string_view {
+		if (index >= views.size()) {
+			return std::string_view();
+		}
+		if (uses[index]++ == 0) {
+			interned[index] = this->strings.intern(views[index], 0);
+		}
+		return interned[index];
+	};
+	for (size_t col = 0; col < this->cols && in.good(); col++) {
+		auto formula = [&](const uint32_t expression, const size_t row, const Value& result) -> FormulaData* {
+			if (expression >= loaded.size()) {
+				return nullptr;
+			}
+			this->expressions.retain(loaded[expression]);
+			FormulaData* stored = this->storeFormula(FormulaData(loaded[expression], static_cast<int>(row), static_cast<int>(col)));
+			stored->restore(result);
+			return stored;
+		};
+		this->columns.emplace_back(in, this->rows, string, formula);
+	}
+	for (size_t i = 0; i < loaded.size(); i++) {
+		this->expressions.release(loaded[i]);
+	}
+	for (size_t i = 0; i < views.size() && in.good(); i++) {
+		if (uses[i] > 0) {
+			this->strings.intern(interned[i], uses[i]);
+		}
+	}
+	if (!in.good()) {
+		this->clear();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Destructor for CellStore.
+ */
+CellStore::~CellStore() {
+	this->clear();
+}
+
+/**
+ * @brief Creates the cell of a classified token.
+ * @details The cell references of a formula are made relative to the cell before its expression
+ * is interned, so formulas copied down a column share one expression.
+ * @param token The classified token.
+ * @param row The row index of the cell.
+ * @param col The column index of the cell.
+ * @return The cell.
+ */
+Cell CellStore::make(Token& token, const size_t row, const size_t col) {
+	Cell cell;
+	cell.size = 0;
+	switch (token.type) {
+	case INT_TOKEN:
+		cell.type = INT;
+		cell.ival = token.ival;
+		break;
+	case DOUBLE_TOKEN:
+		cell.type = DOUBLE;
+		cell.dval = token.dval;
+		break;
+	case FORMULA_TOKEN:
+		cell.type = FORMULA;
+		FormulaData::makeRelative(token.code, static_cast<int>(row), static_cast<int>(col));
+		cell.fval = this->storeFormula(FormulaData(this->expressions.intern(std::move(token.code)), static_cast<int>(row), static_cast<int>(col)));
+		break;
+	default:
+		cell.type = STRING;
+		cell.sval = this->strings.intern(token.text).data();
+		cell.size = token.text.size();
+		break;
+	}
+	return cell;
+}
+
+/**
+ * @brief Releases the string or the formula of a cell.
+ * @details A formula drops its expression, is destroyed and its memory goes back to the free list of its size class.
+ * @param cell The cell being overwritten.
+ */
+void CellStore::release(const Cell& cell) {
+	if (cell.type == STRING && cell.sval != nullptr) {
+		this->strings.release(std::string_view(cell.sval, cell.size));
+	}
+	else if (cell.type == FORMULA) {
+		this->expressions.release(cell.fval->getExpression());
+		cell.fval->~FormulaData();
+		this->arena.deallocate(cell.fval, sizeof(FormulaData));
+	}
+}
+
+/**
+ * @brief Destroys all formulas of the store.
+ * @details Only mixed columns can hold formulas once the store is columnized.
+ */
+void CellStore::destroyFormulas() {
+	for (size_t i = 0; i < this->cells.size(); i++) {
+		if (this->cells[i].type == FORMULA) {
+			this->cells[i].fval->~FormulaData();
+		}
+	}
+	for (size_t col = 0; col < this->columns.size(); col++) {
+		if (this->columns[col].getType() != MIXED_COLUMN) {
+			continue;
+		}
+		for (size_t row = 0; row < this->rows; row++) {
+			Cell cell = this->columns[col].get(row);
+			if (cell.type == FORMULA) {
+				cell.fval->~FormulaData();
+			}
+		}
+	}
+}
+
+/**
+ * @brief Creates a formula in the arena.
+ * @param formula The formula to move into the arena.
+ * @return The stored formula.
+ */
+FormulaData* CellStore::storeFormula(FormulaData&& formula) {
+	void* memory = this->arena.allocate(sizeof(FormulaData));
+	try {
+		return new (memory) FormulaData(std::move(formula));
+	}
+	catch (std::bad_alloc& e) {
+		this->arena.deallocate(memory, sizeof(FormulaData));
+		throw;
+	}
+}
@@ -0,0 +1,187 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <string_view>
+#include "Cell.h"
+#include "Column.h"
+#include "Arena.h"
+#include "StringPool.h"
+#include "ExpressionPool.h"
+#include "CellView.h"
+#include "FormulaData.h"
+#include "Token.h"
+#include "Aggregate.h"
+
+/**
+ * @class CellStore
+ * @brief Stores the cells of a table in one contiguous, row-major array of 16 byte slots.
+ *
+ * Rows are appended one at a time while a table is loaded and may have different lengths
+ * until pad() makes them all the same width. A padded store can be converted to typed
+ * columns with columnize(). Strings are interned in a pool owned by the store, so equal
+ * strings share one copy, and formulas are allocated in an arena owned by the store. Formulas
+ * written the same way share one compiled expression from the store's expression pool. The
+ * cells only point at them, so clearing the store frees them all at once.
+ */
+class CellStore {
+public:
+	/**
+	 * @brief Constructs an empty CellStore object.
+	 */
+	CellStore();
+
+	CellStore(const CellStore&) = delete; /**< Disable copy constructor. */
+	CellStore& operator=(const CellStore&) = delete; /**< Disable assignment operator. */
+
+	/**
+	 * @brief Retrieves a cell of a padded store.
+	 * @param row The row index of the cell.
+	 * @param col The column index of the cell.
+	 * @return The cell.
+	 */
+	Cell at(const size_t row, const size_t col) const;
+
+	/**
+	 * @brief Retrieves a cell of a padded store through the Data interface.
+	 * @param row The row index of the cell.
+	 * @param col The column index of the cell.
+	 * @return A view of the cell.
+	 */
+	CellView view(const size_t row, const size_t col) const;
+
+	/**
+	 * @brief Retrieves the number of rows in the store.
+	 * @return The number of rows.
+	 */
+	size_t getRows() const;
+
+	/**
+	 * @brief Retrieves the number of columns of a padded store.
+	 * @return The number of columns.
+	 */
+	size_t getCols() const;
+
+	/**
+	 * @brief Starts a new, empty row at the end of the store.
+	 */
+	void addRow();
+
+	/**
+	 * @brief Appends a cell to the last row of the store.
+	 * @param token The classified token holding the value of the cell.
+	 */
+	void add(Token& token);
+
+	/**
+	 * @brief Replaces a cell of a padded store.
+	 * @param row The row index of the cell.
+	 * @param col The column index of the cell.
+	 * @param token The classified token holding the new value of the cell.
+	 */
+	void set(const size_t row, const size_t col, Token& token);
+
+	/**
+	 * @brief Gives every row the same number of cells, missing cells become empty strings.
+	 * @param width The number of cells of every row, at least the length of the longest row.
+	 */
+	void pad(const size_t width);
+
+	/**
+	 * @brief Converts a padded store to one typed column per table column.
+	 */
+	void columnize();
+
+	/**
+	 * @brief Computes the length of the longest string representation in a column of a padded store.
+	 * @param col The column index.
+	 * @return The length of the longest string representation.
+	 */
+	size_t width(const size_t col) const;
+
+	/**
+	 * @brief Adds the numbers of a range of a padded store to an aggregate.
+	 * @param range The range, it must lie inside the store.
+	 * @param total The aggregate to add to.
+	 * @param table The table formulas read their cells from.
+	 */
+	void aggregate(const CellRange& range, Aggregate& total, const Table& table) const;
+
+	/**
+	 * @brief Moves all rows of another store to the end of this one.
+	 * @param other The store to take the rows from, it is left empty.
+	 */
+	void append(CellStore& other);
+
+	/**
+	 * @brief Removes all cells from the store.
+	 */
+	void clear();
+
+	/**
+	 * @brief Computes the memory used by the store.
+	 * @return The number of bytes held by the cells, the string pool and the arena.
+	 */
+	size_t memoryUsage() const;
+
+	/**
+	 * @brief Describes how much interning saves in every column that holds strings.
+	 * @return One line per column with its string cells, distinct strings, dedup ratio and bytes saved.
+	 */
+	std::string stringReport() const;
+
+	/**
+	 * @brief Writes a padded store to a snapshot.
+	 * @param out The snapshot.
+	 */
+	void writeSnapshot(SnapshotWriter& out) const;
+
+	/**
+	 * @brief Replaces the cells of the store with the ones of a snapshot.
+	 * @param in The snapshot, at the part written by writeSnapshot().
+	 * @return `true` if the snapshot was valid, `false` otherwise, the store is then empty.
+	 * @throws std::bad_alloc If there is not enough memory, the store must then be cleared.
+	 */
+	bool readSnapshot(SnapshotReader& in);
+
+	/**
+	 * @brief Destructs the CellStore object, destroying its formulas and releasing its arena.
+	 */
+	~CellStore();
+
+private:
+	/**
+	 * @brief Creates the cell of a classified token, interning its string or allocating its formula in the arena.
+	 * @param token The classified token.
+	 * @param row The row index of the cell.
+	 * @param col The column index of the cell.
+	 * @return The cell.
+	 */
+	Cell make(Token& token, const size_t row, const size_t col);
+
+	/**
+	 * @brief Releases the string or the formula of a cell.
+	 * @param cell The cell being overwritten.
+	 */
+	void release(const Cell& cell);
+
+	/**
+	 * @brief Destroys all formulas of the store.
+	 */
+	void destroyFormulas();
+
+	/**
+	 * @brief Creates a formula in the arena.
+	 * @param formula The formula to move into the arena.
+	 * @return The stored formula.
+	 */
+	FormulaData* storeFormula(FormulaData&& formula);
+
+	std::vector<Cell> cells; /**< The cells, row after row, until the store is columnized. */
+	std::vector<Column> columns; /**< The cells, column after column, once the store is columnized. */
+	std::vector<size_t> rowStart; /**< The index of the first cell of every row, until the store is padded. */
+	size_t rows; /**< The number of rows. */
+	size_t cols; /**< The number of cells of every row, 0 until the store is padded. */
+	StringPool strings; /**< The strings of the string cells. */
+	ExpressionPool expressions; /**< The compiled expressions of the formula cells. */
+	Arena arena; /**< The memory of the formulas. */
+};
@@ -0,0 +1,124 @@
+#include "CellView.h"
+#include "IntData.h"
+#include "DoubleData.h"
+#include "StringData.h"
+#include "FormulaData.h"
+
+/**
+ * @brief Constructor for CellView.
+ * @param cell The cell to view.
+ */
+CellView::CellView(const Cell& cell) : cell(cell) {
+	this->type = cell.type;
+}
+
+/**
+ * @brief Converts the viewed cell to a string representation.
+ * @details The conversion is done by the data class of the cell's type.
+ * @return The string representation of the cell.
+ */
+std::string CellView::stringify() const {
+	switch (this->cell.type) {
+	case INT:
+		return IntData(this->cell.ival).stringify();
+	case DOUBLE:
+		return DoubleData(this->cell.dval).stringify();
+	case STRING:
+		return StringData(std::string_view(this->cell.sval, this->cell.size)).stringify();
+	default:
+		return this->cell.fval->stringify();
+	}
+}
+
+/**
+ * @brief Converts the viewed cell to a string representation for file output.
+ * @details The conversion is done by the data class of the cell's type.
+ * @return The string representation of the cell for file output.
+ */
+std::string CellView::stringifyFile() const {
+	switch (this->cell.type) {
+	case INT:
+		return IntData(this->cell.ival).stringifyFile();
+	case DOUBLE:
+		return DoubleData(this->cell.dval).stringifyFile();
+	case STRING:
+		return StringData(std::string_view(this->cell.sval, this->cell.size)).stringifyFile();
+	default:
+		return this->cell.fval->stringifyFile();
+	}
+}
+
+/**
+ * @brief Writes the string representation of the viewed cell into a caller-supplied buffer.
+ * @details The conversion is done by the data class of the cell's type, without allocating.
+ * @param buffer The buffer to write to.
+ * @param size The size of the buffer.
+ * @return The length of the whole string representation.
+ */
+size_t CellView::format(char* buffer, const size_t size) const {
+	switch (this->cell.type) {
+	case INT:
+		return IntData(this->cell.ival).format(buffer, size);
+	case DOUBLE:
+		return DoubleData(this->cell.dval).format(buffer, size);
+	case STRING:
+		return StringData(std::string_view(this->cell.sval, this->cell.size)).format(buffer, size);
+	default:
+		return this->cell.fval->format(buffer, size);
+	}
+}
+
+/**
+ * @brief Writes the string representation of the viewed cell for file output into a caller-supplied buffer.
+ * @details The conversion is done by the data class of the cell's type.
+ * @param buffer The buffer to write to.
+ * @param size The size of the buffer.
+ * @return The length of the whole string representation for file output.
+ */
+size_t CellView::formatFile(char* buffer, const size_t size) const {
+	switch (this->cell.type) {
+	case INT:
+		return IntData(this->cell.ival).formatFile(buffer, size);
+	case DOUBLE:
+		return DoubleData(this->cell.dval).formatFile(buffer, size);
+	case STRING:
+		return StringData(std::string_view(this->cell.sval, this->cell.size)).formatFile(buffer, size);
+	default:
+		return this->cell.fval->formatFile(buffer, size);
+	}
+}
+
+/**
+ * @brief Retrieves the data type of the viewed cell.
+ * @return The data type of the cell.
+ */
+DataType CellView::getType() const {
+	return this->type;
+}
+
+/**
+ * @brief Evaluates the viewed cell to a typed number.
+ * @details The evaluation is done by the data class of the cell's type, no text is produced.
+ * @param table The table the cells referenced by a formula are read from.
+ * @return The number, or an ERROR_VALUE if the cell is not a number.
+ */
+Value CellView::evaluate(const Table& table) const {
+	switch (this->cell.type) {
+	case INT:
+		return IntData(this->cell.ival).evaluate(table);
+	case DOUBLE:
+		return DoubleData(this->cell.dval).evaluate(table);
+	case STRING:
+		return StringData(std::string_view(this->cell.sval, this->cell.size)).evaluate(table);
+	default:
+		return this->cell.fval->evaluate(table);
+	}
+}
+
+/**
+ * @brief Retrieves the viewed cell.
+ * @return The cell.
+ */
+const Cell& CellView::getCell() const {
+	return this->cell;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "Data.h"
+#include "Cell.h"
+
+/**
+ * @class CellView
+ * @brief Exposes a cell of a CellStore through the Data interface.
+ */
+class CellView : public Data {
+public:
+	/**
+	 * @brief Constructs a view of a cell.
+	 * @param cell The cell to view.
+	 */
+	CellView(const Cell& cell);
+
+	/**
+	 * @brief Converts the viewed cell to a string representation.
+	 * @return A string representation of the cell.
+	 */
+	virtual std::string stringify() const override;
+
+	/**
+	 * @brief Converts the viewed cell to a string representation for file output.
+	 * @return A string representation of the cell for file output.
+	 */
+	virtual std::string stringifyFile() const override;
+
+	/**
+	 * @brief Writes the string representation of the viewed cell into a caller-supplied buffer.
+	 * @param buffer The buffer to write to.
+	 * @param size The size of the buffer.
+	 * @return The length of the whole string representation.
+	 */
+	virtual size_t format(char* buffer, const size_t size) const override;
+
+	/**
+	 * @brief Writes the string representation of the viewed cell for file output into a caller-supplied buffer.
+	 * @param buffer The buffer to write to.
+	 * @param size The size of the buffer.
+	 * @return The length of the whole string representation for file output.
+	 */
+	virtual size_t formatFile(char* buffer, const size_t size) const override;
+
+	/**
+	 * @brief Retrieves the data type of the viewed cell.
+	 * @return The data type of the cell.
+	 */
+	virtual DataType getType() const override;
+
+	/**
+	 * @brief Evaluates the viewed cell to a typed number.
+	 * @param table The table the cells referenced by a formula are read from.
+	 * @return The number, or an ERROR_VALUE if the cell is not a number.
+	 */
+	virtual Value evaluate(const Table& table) const override;
+
+	/**
+	 * @brief Retrieves the viewed cell.
+	 * @return The cell.
+	 */
+	const Cell& getCell() const;
+
+	/**
+	 * @brief Destructs the CellView object.
+	 */
+	~CellView() override {}
+
+private:
+	Cell cell; /**< The viewed cell. */
+};
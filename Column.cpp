@@ -0,0 +1,527 @@
+#include "Column.h"
+#include "CellView.h"
+#include "DoubleData.h"
+#include "FormulaData.h"
+#include "SnapshotRecord.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+/**
+ * @brief Creates the cell of an empty string.
+ * @return The empty cell.
+ */
+static Cell emptyCell() {
+	Cell cell;
+	cell.sval = nullptr;
+	cell.type = STRING;
+	cell.size = 0;
+	return cell;
+}
+
+/**
+ * @brief Computes the length of the decimal representation of an integer.
+ * @param value The integer.
+ * @return The number of characters std::to_string would produce.
+ */
+static size_t intLength(const int value) {
+	size_t length = value < 0 ? 2 : 1;
+	unsigned long long magnitude = value < 0 ? -static_cast<long long>(value) : value;
+	while (magnitude >= 10) {
+		magnitude /= 10;
+		length++;
+	}
+	return length;
+}
+
+/**
+ * @brief Sums a run of numbers and finds its smallest and biggest one.
+ * @details The run is split over four independent accumulators, so consecutive additions do not
+ * wait for each other and the compiler can turn the loop into SIMD reductions.
+ * @param values The first number of the run.
+ * @param count The length of the run.
+ * @param sum The sum to add to.
+ * @param low The minimum to lower.
+ * @param high The maximum to raise.
+ */
+template <typename T, typename S>
+static void reduce(const T* values, const size_t count, S& sum, T& low, T& high) {
+	S sums[4] = { 0, 0, 0, 0 };
+	T lows[4] = { low, low, low, low };
+	T highs[4] = { high, high, high, high };
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		for (size_t k = 0; k < 4; k++) {
+			sums[k] += values[i + k];
+			lows[k] = values[i + k] < lows[k] ? values[i + k] : lows[k];
+			highs[k] = values[i + k] > highs[k] ? values[i + k] : highs[k];
+		}
+	}
+	for (; i < count; i++) {
+		sums[0] += values[i];
+		lows[0] = values[i] < lows[0] ? values[i] : lows[0];
+		highs[0] = values[i] > highs[0] ? values[i] : highs[0];
+	}
+	sum += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+	low = std::min(std::min(lows[0], lows[1]), std::min(lows[2], lows[3]));
+	high = std::max(std::max(highs[0], highs[1]), std::max(highs[2], highs[3]));
+}
+
+/**
+ * @brief Constructor for Column.
+ * @details The column gets the type shared by all of its non-empty cells, or MIXED_COLUMN if their types differ.
+ * @param cells The first cell of the column.
+ * @param rows The number of cells in the column.
+ * @param stride The distance between two cells of the column.
+ */
+Column::Column(const Cell* cells, const size_t rows, const size_t stride) : type(STRING_COLUMN), rows(rows), nulls((rows + 63) / 64, 0) {
+	bool seen = false;
+	DataType common = STRING;
+	for (size_t i = 0; i < rows; i++) {
+		const Cell& cell = cells[i * stride];
+		if (cell.type == STRING && cell.sval == nullptr) {
+			continue;
+		}
+		if (!seen) {
+			common = cell.type;
+			seen = true;
+		}
+		else if (cell.type != common) {
+			common = FORMULA;
+			break;
+		}
+	}
+
+	switch (common) {
+	case INT:
+		this->type = INT_COLUMN;
+		this->ints.resize(rows, 0);
+		break;
+	case DOUBLE:
+		this->type = DOUBLE_COLUMN;
+		this->doubles.resize(rows, 0.0);
+		break;
+	case STRING:
+		this->type = STRING_COLUMN;
+		this->strings.resize(rows);
+		break;
+	default:
+		this->type = MIXED_COLUMN;
+		this->mixed.resize(rows, emptyCell());
+		break;
+	}
+	for (size_t i = 0; i < rows; i++) {
+		this->set(i, cells[i * stride]);
+	}
+}
+
+/**
+ * @brief Constructor for Column from a snapshot.
+ * @details The block holds the type of the column, the null bitmap and the values in the layout of
+ * the column. Integers and doubles are read straight into the value array. Strings are stored as
+ * indices into the string dictionary of the snapshot. A mixed column stores the type of every cell,
+ * one 64 bit payload per cell, which is the value, the string index or the expression index, and
+ * then the saved results of its formulas in row order. A cell is only set once it is checked, so
+ * a column whose block turns out invalid holds no half made formulas, and every failure pads the
+ * rest of the column with empty cells, so clearing it never reads past its cells.
+ * @param in The snapshot, at the block of the column.
+ * @param rows The number of cells in the column.
+ * @param strings Retrieves the interned string with a given index for one more cell.
+ * @param formulas Creates a formula from its expression index, its row index and its saved result.
+ */
+Column::Column(SnapshotReader& in, const size_t rows, const std::function<std::string_view(const uint64_t)>& strings,
+	const std::function<FormulaData*(const uint32_t, const size_t, const Value&)>& formulas) : type(STRING_COLUMN), rows(rows) {
+	uint32_t type = in.readValue<uint32_t>();
+	in.readArray(this->nulls, (rows + 63) / 64);
+	std::vector<uint32_t> indices;
+	std::vector<uint8_t> types;
+	std::vector<uint64_t> payloads;
+	std::vector<StoredValue> results;
+	switch (type) {
+	case INT_COLUMN:
+		in.readArray(this->ints, rows);
+		break;
+	case DOUBLE_COLUMN:
+		in.readArray(this->doubles, rows);
+		break;
+	case STRING_COLUMN:
+		in.readArray(indices, rows);
+		break;
+	case MIXED_COLUMN:
+		if (in.readArray(types, rows) && in.readArray(payloads, rows)) {
+			size_t count = 0;
+			for (size_t i = 0; i < rows; i++) {
+				count += !this->isNull(i) && types[i] == FORMULA;
+			}
+			in.readArray(results, count);
+		}
+		break;
+	default:
+		in.fail();
+		break;
+	}
+	if (!in.good()) {
+		this->rows = 0;
+		this->nulls.clear();
+		this->ints.clear();
+		this->doubles.clear();
+		return;
+	}
+	this->type = static_cast<ColumnType>(type);
+	if (this->type == STRING_COLUMN) {
+		this->strings.reserve(rows);
+		for (size_t i = 0; i < rows; i++) {
+			if (this->isNull(i)) {
+				this->strings.emplace_back();
+				continue;
+			}
+			std::string_view value = strings(indices[i]);
+			if (value.empty()) {
+				this->strings.resize(rows);
+				in.fail();
+				return;
+			}
+			this->strings.push_back(value);
+		}
+	}
+	if (this->type != MIXED_COLUMN) {
+		return;
+	}
+	this->mixed.reserve(rows);
+	size_t formula = 0;
+	for (size_t i = 0; i < rows; i++) {
+		Cell cell = emptyCell();
+		if (this->isNull(i)) {
+			this->mixed.push_back(cell);
+			continue;
+		}
+		switch (types[i]) {
+		case INT:
+			cell.type = INT;
+			cell.ival = static_cast<int>(static_cast<uint32_t>(payloads[i]));
+			break;
+		case DOUBLE:
+			cell.type = DOUBLE;
+			std::memcpy(&cell.dval, &payloads[i], sizeof(double));
+			break;
+		case STRING: {
+			std::string_view value = strings(payloads[i]);
+			if (value.empty()) {
+				in.fail();
+				break;
+			}
+			cell.sval = value.data();
+			cell.size = value.size();
+			break;
+		}
+		case FORMULA: {
+			Value result;
+			if (payloads[i] > UINT32_MAX || results[formula].type > static_cast<uint32_t>(CYCLE_VALUE)) {
+				in.fail();
+				break;
+			}
+			result.type = static_cast<ValueType>(results[formula].type);
+			result.ival = results[formula].ival;
+			result.dval = results[formula].dval;
+			if ((cell.fval = formulas(static_cast<uint32_t>(payloads[i]), i, result)) == nullptr) {
+				in.fail();
+				break;
+			}
+			cell.type = FORMULA;
+			formula++;
+			break;
+		}
+		default:
+			in.fail();
+			break;
+		}
+		if (!in.good()) {
+			this->mixed.resize(rows, emptyCell());
+			return;
+		}
+		this->mixed.push_back(cell);
+	}
+}
+
+/**
+ * @brief Retrieves a cell of the column.
+ * @param row The row index of the cell.
+ * @return The cell, an empty string for a null.
+ */
+Cell Column::get(const size_t row) const {
+	Cell cell = emptyCell();
+	if (this->isNull(row)) {
+		return cell;
+	}
+	switch (this->type) {
+	case INT_COLUMN:
+		cell.type = INT;
+		cell.ival = this->ints[row];
+		break;
+	case DOUBLE_COLUMN:
+		cell.type = DOUBLE;
+		cell.dval = this->doubles[row];
+		break;
+	case STRING_COLUMN:
+		cell.sval = this->strings[row].data();
+		cell.size = this->strings[row].size();
+		break;
+	default:
+		cell = this->mixed[row];
+		break;
+	}
+	return cell;
+}
+
+/**
+ * @brief Replaces a cell of the column.
+ * @details A typed column becomes mixed when the new, non-empty cell has a different type.
+ * @param row The row index of the cell.
+ * @param cell The new cell.
+ */
+void Column::set(const size_t row, const Cell& cell) {
+	bool null = cell.type == STRING && cell.sval == nullptr;
+	if (!null && ((this->type == INT_COLUMN && cell.type != INT) || (this->type == DOUBLE_COLUMN && cell.type != DOUBLE)
+		|| (this->type == STRING_COLUMN && cell.type != STRING))) {
+		this->demote();
+	}
+	this->setNull(row, null);
+	switch (this->type) {
+	case INT_COLUMN:
+		this->ints[row] = null ? 0 : cell.ival;
+		break;
+	case DOUBLE_COLUMN:
+		this->doubles[row] = null ? 0.0 : cell.dval;
+		break;
+	case STRING_COLUMN:
+		this->strings[row] = std::string_view(cell.sval, cell.size);
+		break;
+	default:
+		this->mixed[row] = cell;
+		break;
+	}
+}
+
+/**
+ * @brief Retrieves how the values of the column are stored.
+ * @return The type of the column.
+ */
+ColumnType Column::getType() const {
+	return this->type;
+}
+
+/**
+ * @brief Computes the length of the longest string representation in the column.
+ * @details Typed columns are measured without building a string for every cell, only
+ * mixed columns go through the Data interface.
+ * @return The length of the longest string representation.
+ */
+size_t Column::width() const {
+	size_t widest = 0;
+	switch (this->type) {
+	case INT_COLUMN:
+		for (size_t i = 0; i < this->rows; i++) {
+			if (!this->isNull(i)) {
+				widest = std::max(widest, intLength(this->ints[i]));
+			}
+		}
+		break;
+	case DOUBLE_COLUMN:
+		for (size_t i = 0; i < this->rows; i++) {
+			if (!this->isNull(i)) {
+				widest = std::max(widest, DoubleData(this->doubles[i]).format(nullptr, 0));
+			}
+		}
+		break;
+	case STRING_COLUMN:
+		for (size_t i = 0; i < this->rows; i++) {
+			widest = std::max(widest, this->strings[i].size());
+		}
+		break;
+	default:
+		for (size_t i = 0; i < this->rows; i++) {
+			widest = std::max(widest, CellView(this->mixed[i]).format(nullptr, 0));
+		}
+		break;
+	}
+	return widest;
+}
+
+/**
+ * @brief Adds the numbers of a run of rows to an aggregate.
+ * @details Integer and double columns are reduced in runs between their nulls straight from the
+ * value array. String columns count their numeric strings, mixed columns go cell by cell.
+ * @param begin The first row.
+ * @param end The row after the last row.
+ * @param total The aggregate to add to.
+ * @param table The table formulas read their cells from.
+ */
+void Column::aggregate(const size_t begin, const size_t end, Aggregate& total, const Table& table) const {
+	if (this->type == STRING_COLUMN || this->type == MIXED_COLUMN) {
+		for (size_t i = begin; i < end; i++) {
+			total.add(this->get(i), table);
+		}
+		return;
+	}
+
+	long long intSum = 0;
+	int intLow = std::numeric_limits<int>::max();
+	int intHigh = std::numeric_limits<int>::min();
+	double sum = 0;
+	double low = std::numeric_limits<double>::infinity();
+	double high = -std::numeric_limits<double>::infinity();
+	size_t count = 0;
+	auto reduceRun = [&](const size_t first, const size_t last) {
+		if (this->type == INT_COLUMN) {
+			reduce(this->ints.data() + first, last - first, intSum, intLow, intHigh);
+		}
+		else {
+			reduce(this->doubles.data() + first, last - first, sum, low, high);
+		}
+		count += last - first;
+	};
+	size_t run = begin;
+	size_t row = begin;
+	while (row < end) {
+		size_t span = std::min<size_t>(64 - row % 64, end - row);
+		uint64_t word = this->nulls[row / 64] >> (row % 64);
+		if (span < 64) {
+			word &= (uint64_t(1) << span) - 1;
+		}
+		if (word == 0) {
+			row += span;
+			continue;
+		}
+		while ((word & 1) == 0) {
+			word >>= 1;
+			row++;
+		}
+		reduceRun(run, row);
+		run = ++row;
+	}
+	reduceRun(run, end);
+	if (count == 0) {
+		return;
+	}
+	if (this->type == INT_COLUMN) {
+		sum = static_cast<double>(intSum);
+		low = intLow;
+		high = intHigh;
+	}
+	total.sum += sum;
+	total.min = std::min(total.min, low);
+	total.max = std::max(total.max, high);
+	total.count += count;
+}
+
+/**
+ * @brief Computes the memory used by the column.
+ * @return The number of bytes held by the value arrays and the null bitmap.
+ */
+size_t Column::memoryUsage() const {
+	return this->nulls.capacity() * sizeof(uint64_t) + this->ints.capacity() * sizeof(int)
+		+ this->doubles.capacity() * sizeof(double) + this->strings.capacity() * sizeof(std::string_view)
+		+ this->mixed.capacity() * sizeof(Cell);
+}
+
+/**
+ * @brief Writes the column as a block of a snapshot.
+ * @details The layout is the one read by the snapshot constructor. The value arrays of integer
+ * and double columns are written as they are. The payload of an empty cell is 0.
+ * @param out The snapshot.
+ * @param strings The index of every interned string in the snapshot, by its data pointer.
+ */
+void Column::writeSnapshot(SnapshotWriter& out, const std::unordered_map<const char*, uint32_t>& strings) const {
+	out.writeValue<uint32_t>(this->type);
+	out.writeArray(this->nulls);
+	if (this->type == INT_COLUMN) {
+		out.writeArray(this->ints);
+		return;
+	}
+	if (this->type == DOUBLE_COLUMN) {
+		out.writeArray(this->doubles);
+		return;
+	}
+	if (this->type == STRING_COLUMN) {
+		std::vector<uint32_t> indices(this->rows, 0);
+		for (size_t i = 0; i < this->rows; i++) {
+			if (!this->isNull(i)) {
+				indices[i] = strings.at(this->strings[i].data());
+			}
+		}
+		out.writeArray(indices);
+		return;
+	}
+	std::vector<uint8_t> types(this->rows, STRING);
+	std::vector<uint64_t> payloads(this->rows, 0);
+	std::vector<StoredValue> results;
+	for (size_t i = 0; i < this->rows; i++) {
+		const Cell& cell = this->mixed[i];
+		types[i] = static_cast<uint8_t>(cell.type);
+		if (this->isNull(i)) {
+			continue;
+		}
+		switch (cell.type) {
+		case INT:
+			payloads[i] = static_cast<uint32_t>(cell.ival);
+			break;
+		case DOUBLE:
+			std::memcpy(&payloads[i], &cell.dval, sizeof(double));
+			break;
+		case STRING:
+			payloads[i] = strings.at(cell.sval);
+			break;
+		default: {
+			Value result = cell.fval->getResult();
+			StoredValue stored;
+			stored.type = static_cast<uint32_t>(result.type);
+			stored.ival = result.ival;
+			stored.dval = result.dval;
+			payloads[i] = cell.fval->getExpression()->index;
+			results.push_back(stored);
+			break;
+		}
+		}
+	}
+	out.writeArray(types);
+	out.writeArray(payloads);
+	out.writeArray(results);
+}
+
+/**
+ * @brief Converts the column to an array of whole cells.
+ */
+void Column::demote() {
+	std::vector<Cell> cells(this->rows);
+	for (size_t i = 0; i < this->rows; i++) {
+		cells[i] = this->get(i);
+	}
+	this->type = MIXED_COLUMN;
+	this->mixed.swap(cells);
+	std::vector<int>().swap(this->ints);
+	std::vector<double>().swap(this->doubles);
+	std::vector<std::string_view>().swap(this->strings);
+}
+
+/**
+ * @brief Checks whether a cell is null.
+ * @param row The row index of the cell.
+ * @return True if the cell is empty, false otherwise.
+ */
+bool Column::isNull(const size_t row) const {
+	return (this->nulls[row / 64] >> (row % 64)) & 1;
+}
+
+/**
+ * @brief Marks a cell as null or not null.
+ * @param row The row index of the cell.
+ * @param null Whether the cell is empty.
+ */
+void Column::setNull(const size_t row, const bool null) {
+	if (null) {
+		this->nulls[row / 64] |= uint64_t(1) << (row % 64);
+	}
+	else {
+		this->nulls[row / 64] &= ~(uint64_t(1) << (row % 64));
+	}
+}
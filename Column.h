@@ -0,0 +1,130 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include "Cell.h"
+#include "Aggregate.h"
+#include "Value.h"
+#include "SnapshotWriter.h"
+#include "SnapshotReader.h"
+
+/**
+ * @enum ColumnType
+ * @brief Represents how the values of a column are stored.
+ */
+enum ColumnType {
+	INT_COLUMN, /**< Every value is an integer. */
+	DOUBLE_COLUMN, /**< Every value is a double. */
+	STRING_COLUMN, /**< Every value is a string. */
+	MIXED_COLUMN /**< The values have different types, or are formulas. */
+};
+
+/**
+ * @class Column
+ * @brief Stores the cells of one table column in a contiguous array of a single type.
+ *
+ * Empty cells are nulls, they are kept in a bitmap and do not decide the type of the column.
+ * A column only falls back to MIXED_COLUMN, an array of whole cells, once it holds values of
+ * different types.
+ */
+class Column {
+public:
+	/**
+	 * @brief Constructs a column from the cells of one column of a row-major array.
+	 * @param cells The first cell of the column.
+	 * @param rows The number of cells in the column.
+	 * @param stride The distance between two cells of the column.
+	 */
+	Column(const Cell* cells, const size_t rows, const size_t stride);
+
+	/**
+	 * @brief Constructs a column from its block of a snapshot.
+	 * @param in The snapshot, at the block of the column. It fails if the block is invalid.
+	 * @param rows The number of cells in the column.
+	 * @param strings Retrieves the interned string of the snapshot with a given index for one more
+	 * cell, an empty view if the index is invalid.
+	 * @param formulas Creates a formula from its expression index, its row index and its saved result,
+	 * `nullptr` if the expression index is invalid.
+	 */
+	Column(SnapshotReader& in, const size_t rows, const std::function<std::string_view(const uint64_t)>& strings,
+		const std::function<FormulaData*(const uint32_t, const size_t, const Value&)>& formulas);
+
+	/**
+	 * @brief Retrieves a cell of the column.
+	 * @param row The row index of the cell.
+	 * @return The cell, an empty string for a null.
+	 */
+	Cell get(const size_t row) const;
+
+	/**
+	 * @brief Replaces a cell of the column, making the column mixed if the types differ.
+	 * @param row The row index of the cell.
+	 * @param cell The new cell.
+	 */
+	void set(const size_t row, const Cell& cell);
+
+	/**
+	 * @brief Retrieves how the values of the column are stored.
+	 * @return The type of the column.
+	 */
+	ColumnType getType() const;
+
+	/**
+	 * @brief Computes the length of the longest string representation in the column.
+	 * @return The length of the longest string representation.
+	 */
+	size_t width() const;
+
+	/**
+	 * @brief Adds the numbers of a run of rows to an aggregate.
+	 * @param begin The first row.
+	 * @param end The row after the last row.
+	 * @param total The aggregate to add to.
+	 * @param table The table formulas read their cells from.
+	 */
+	void aggregate(const size_t begin, const size_t end, Aggregate& total, const Table& table) const;
+
+	/**
+	 * @brief Computes the memory used by the column.
+	 * @return The number of bytes held by the value arrays and the null bitmap.
+	 */
+	size_t memoryUsage() const;
+
+	/**
+	 * @brief Writes the column as a block of a snapshot.
+	 * @param out The snapshot.
+	 * @param strings The index of every interned string in the snapshot, by its data pointer.
+	 */
+	void writeSnapshot(SnapshotWriter& out, const std::unordered_map<const char*, uint32_t>& strings) const;
+
+private:
+	/**
+	 * @brief Converts the column to an array of whole cells.
+	 */
+	void demote();
+
+	/**
+	 * @brief Checks whether a cell is null.
+	 * @param row The row index of the cell.
+	 * @return True if the cell is empty, false otherwise.
+	 */
+	bool isNull(const size_t row) const;
+
+	/**
+	 * @brief Marks a cell as null or not null.
+	 * @param row The row index of the cell.
+	 * @param null Whether the cell is empty.
+	 */
+	void setNull(const size_t row, const bool null);
+
+	ColumnType type; /**< How the values are stored. */
+	size_t rows; /**< The number of cells in the column. */
+	std::vector<uint64_t> nulls; /**< One bit per cell, set for the empty cells. */
+	std::vector<int> ints; /**< The values of an INT_COLUMN. */
+	std::vector<double> doubles; /**< The values of a DOUBLE_COLUMN. */
+	std::vector<std::string_view> strings; /**< The values of a STRING_COLUMN. */
+	std::vector<Cell> mixed; /**< The cells of a MIXED_COLUMN. */
+};
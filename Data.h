@@ -1,6 +1,10 @@
 #pragma once
 #include <iostream>
 #include <string>
+#include <cstring>
+#include "Value.h"
+
+class Table;
 
 /**
  * @enum DataType
@@ -32,17 +36,58 @@ public:
 	 */
 	virtual std::string stringifyFile() const = 0;
 
+	/**
+	 * @brief Writes the string representation of the data object into a caller-supplied buffer.
+	 * @param buffer The buffer to write to, the text is not null-terminated.
+	 * @param size The size of the buffer.
+	 * @return The length of the whole string representation, it is only written completely if it fits.
+	 * @note Nothing is allocated, a buffer of FORMAT_BUFFER_SIZE fits the representation of any number.
+	 */
+	virtual size_t format(char* buffer, const size_t size) const = 0;
+
+	/**
+	 * @brief Writes the string representation of the data object for file output into a caller-supplied buffer.
+	 * @param buffer The buffer to write to, the text is not null-terminated.
+	 * @param size The size of the buffer.
+	 * @return The length of the whole representation, it is only written completely if it fits.
+	 */
+	virtual size_t formatFile(char* buffer, const size_t size) const = 0;
+
 	/**
 	 * @brief Retrieves the data type of the object.
 	 * @return The data type of the object.
 	 */
 	virtual DataType getType() const = 0;
 
+	/**
+	 * @brief Evaluates the data object to a typed number, without going through its text.
+	 * @param table The table the cells referenced by a formula are read from.
+	 * @return The number, or an ERROR_VALUE if the data is not a number.
+	 */
+	virtual Value evaluate(const Table& table) const = 0;
+
 	/**
 	 * @brief Destructs the Data object.
 	 */
 	virtual ~Data() {};
 
+	static const size_t FORMAT_BUFFER_SIZE = 512; /**< The buffer size that fits the string representation of any number. */
+
 protected:
+	/**
+	 * @brief Copies as much of a text as fits into a buffer.
+	 * @param buffer The buffer to write to.
+	 * @param size The size of the buffer.
+	 * @param text The text to copy.
+	 * @param length The length of the text.
+	 * @return The length of the text.
+	 */
+	static size_t copyText(char* buffer, const size_t size, const char* text, const size_t length) {
+		if (size > 0 && length > 0) {
+			std::memcpy(buffer, text, length < size ? length : size);
+		}
+		return length;
+	}
+
 	DataType type; /**< The data type of the object. */
 };
\ No newline at end of file
@@ -0,0 +1,428 @@
+#include "DependencyGraph.h"
+#include <algorithm>
+#include <climits>
+#include <unordered_set>
+
+/**
+ * @brief Default constructor for DependencyGraph.
+ * @details Initializes a graph without formulas.
+ */
+DependencyGraph::DependencyGraph() {}
+
+/**
+ * @brief Sets the cells a formula cell reads, replacing its previous edges.
+ * @details Operands with negative indices can never be edited and are left out. A range gets one
+ * reverse edge per column it covers instead of one per cell, appended to the edges of the column.
+ * @param row The row index of the formula cell.
+ * @param col The column index of the formula cell.
+ * @param precedents The row and column indices of the cells the formula reads.
+ * @param ranges The ranges the formula reads, clipped to the table.
+ */
+void DependencyGraph::link(const unsigned row, const unsigned col, const std::vector<std::pair<int, int>>& precedents,
+	const std::vector<CellRange>& ranges) {
+	this->unlink(row, col);
+	uint64_t formula = key(row, col);
+	std::vector<uint64_t> edges;
+	for (size_t i = 0; i < precedents.size(); i++) {
+		if (precedents[i].first < 0 || precedents[i].second < 0) {
+			continue;
+		}
+		uint64_t cell = key(precedents[i].first, precedents[i].second);
+		if (std::find(edges.begin(), edges.end(), cell) == edges.end()) {
+			edges.push_back(cell);
+			this->readers[cell].push_back(formula);
+		}
+	}
+	if (!edges.empty()) {
+		this->precedents.emplace(formula, std::move(edges));
+	}
+	if (ranges.empty()) {
+		return;
+	}
+	for (size_t i = 0; i < ranges.size(); i++) {
+		for (int column = ranges[i].left; column <= ranges[i].right; column++) {
+			RangeColumn& edges = this->rangeReaders[column];
+			edges.edges.push_back(RangeEdge{ ranges[i].top, ranges[i].bottom, formula });
+			edges.reach.clear();
+		}
+	}
+	this->rangePrecedents.emplace(formula, ranges);
+}
+
+/**
+ * @brief Removes the edges of a cell that no longer holds a formula.
+ * @details The reverse edges of other formulas to the cell are kept, they still read it.
+ * @param row The row index of the cell.
+ * @param col The column index of the cell.
+ */
+void DependencyGraph::unlink(const unsigned row, const unsigned col) {
+	uint64_t formula = key(row, col);
+	auto found = this->precedents.find(formula);
+	if (found != this->precedents.end()) {
+		for (size_t i = 0; i < found->second.size(); i++) {
+			auto cell = this->readers.find(found->second[i]);
+			std::vector<uint64_t>& edges = cell->second;
+			edges.erase(std::find(edges.begin(), edges.end(), formula));
+			if (edges.empty()) {
+				this->readers.erase(cell);
+			}
+		}
+		this->precedents.erase(found);
+	}
+	auto ranges = this->rangePrecedents.find(formula);
+	if (ranges == this->rangePrecedents.end()) {
+		return;
+	}
+	for (size_t i = 0; i < ranges->second.size(); i++) {
+		for (int column = ranges->second[i].left; column <= ranges->second[i].right; column++) {
+			auto readers = this->rangeReaders.find(column);
+			if (readers == this->rangeReaders.end()) {
+				continue;
+			}
+			RangeColumn& edges = readers->second;
+			size_t kept = 0;
+			size_t sorted = 0;
+			for (size_t j = 0; j < edges.edges.size(); j++) {
+				if (edges.edges[j].formula == formula) {
+					continue;
+				}
+				if (j < edges.sorted) {
+					sorted++;
+				}
+				edges.edges[kept++] = edges.edges[j];
+			}
+			edges.edges.resize(kept);
+			edges.sorted = sorted;
+			edges.reach.clear();
+			if (edges.edges.empty()) {
+				this->rangeReaders.erase(readers);
+			}
+		}
+	}
+	this->rangePrecedents.erase(ranges);
+}
+
+/**
+ * @brief Collects the formulas that read a cell, directly or through other formulas.
+ * @details The reverse edges are followed with a work list instead of recursion, so long chains
+ * cannot overflow the stack. Every formula is listed once, cycles included.
+ * @param row The row index of the cell.
+ * @param col The column index of the cell.
+ * @return The row and column indices of the dependent formulas, in no particular order.
+ */
+std::vector<std::pair<unsigned, unsigned>> DependencyGraph::dependents(const unsigned row, const unsigned col) const {
+	std::vector<std::pair<unsigned, unsigned>> found;
+	std::unordered_set<uint64_t> visited;
+	std::vector<uint64_t> pending(1, key(row, col));
+	std::vector<uint64_t> next;
+	visited.insert(pending.back());
+	while (!pending.empty()) {
+		uint64_t cell = pending.back();
+		pending.pop_back();
+		next.clear();
+		this->readersOf(cell, next);
+		for (size_t i = 0; i < next.size(); i++) {
+			if (visited.insert(next[i]).second) {
+				pending.push_back(next[i]);
+				found.push_back(std::make_pair(static_cast<unsigned>(next[i] >> 32), static_cast<unsigned>(next[i])));
+			}
+		}
+	}
+	return found;
+}
+
+/**
+ * @brief Groups formulas into levels that can each be evaluated in parallel.
+ * @details Every formula waits for the formulas of the group it reads. The first level holds the
+ * formulas that wait for none, every following level the formulas whose last awaited formula is in
+ * the level before. Formulas that are still waiting at the end are part of a cycle or read one.
+ * @param formulas The row and column indices of the formulas to group, formulas outside of them count as evaluated.
+ * @param blocked Receives the formulas that are part of a cycle of the group or read one.
+ * @return The levels, every formula only reads formulas of earlier levels.
+ */
+std::vector<std::vector<std::pair<unsigned, unsigned>>> DependencyGraph::levels(const std::vector<std::pair<unsigned, unsigned>>& formulas,
+	std::vector<std::pair<unsigned, unsigned>>& blocked) const {
+	std::vector<size_t> first;
+	std::vector<size_t> targets;
+	this->edgesWithin(formulas, first, targets);
+
+	std::vector<size_t> readerFirst(formulas.size() + 1, 0);
+	for (size_t i = 0; i < targets.size(); i++) {
+		readerFirst[targets[i] + 1]++;
+	}
+	for (size_t i = 0; i < formulas.size(); i++) {
+		readerFirst[i + 1] += readerFirst[i];
+	}
+	std::vector<size_t> readers(targets.size());
+	std::vector<size_t> filled(readerFirst.begin(), readerFirst.end() - 1);
+	for (size_t i = 0; i < formulas.size(); i++) {
+		for (size_t j = first[i]; j < first[i + 1]; j++) {
+			readers[filled[targets[j]]++] = i;
+		}
+	}
+
+	std::vector<size_t> waiting(formulas.size());
+	std::vector<size_t> current;
+	for (size_t i = 0; i < formulas.size(); i++) {
+		waiting[i] = first[i + 1] - first[i];
+		if (waiting[i] == 0) {
+			current.push_back(i);
+		}
+	}
+	std::vector<std::vector<std::pair<unsigned, unsigned>>> levels;
+	std::vector<size_t> next;
+	while (!current.empty()) {
+		levels.emplace_back();
+		levels.back().reserve(current.size());
+		next.clear();
+		for (size_t i = 0; i < current.size(); i++) {
+			levels.back().push_back(formulas[current[i]]);
+			for (size_t j = readerFirst[current[i]]; j < readerFirst[current[i] + 1]; j++) {
+				if (--waiting[readers[j]] == 0) {
+					next.push_back(readers[j]);
+				}
+			}
+		}
+		current.swap(next);
+	}
+	for (size_t i = 0; i < formulas.size(); i++) {
+		if (waiting[i] > 0) {
+			blocked.push_back(formulas[i]);
+		}
+	}
+	return levels;
+}
+
+/**
+ * @brief Finds the formulas that read themselves, directly or through other formulas.
+ * @details Tarjan's algorithm, run with an explicit stack so long chains cannot overflow the call
+ * stack. Every strongly connected component with more than one formula is a cycle, and so is a
+ * single formula reading itself. Runs in time linear in the number of formulas and edges.
+ * @param formulas The row and column indices of the formulas to search, only edges between them are followed.
+ * @param acyclic Receives the formulas that are not part of a cycle.
+ * @return The formulas that are part of a cycle.
+ */
+std::vector<std::pair<unsigned, unsigned>> DependencyGraph::cycles(const std::vector<std::pair<unsigned, unsigned>>& formulas,
+	std::vector<std::pair<unsigned, unsigned>>& acyclic) const {
+	static const size_t UNVISITED = static_cast<size_t>(-1);
+	std::vector<size_t> first;
+	std::vector<size_t> targets;
+	this->edgesWithin(formulas, first, targets);
+
+	std::vector<size_t> order(formulas.size(), UNVISITED);
+	std::vector<size_t> low(formulas.size(), 0);
+	std::vector<char> onStack(formulas.size(), false);
+	std::vector<char> inCycle(formulas.size(), false);
+	std::vector<size_t> component;
+	std::vector<std::pair<size_t, size_t>> path;
+	size_t visited = 0;
+	for (size_t start = 0; start < formulas.size(); start++) {
+		if (order[start] != UNVISITED) {
+			continue;
+		}
+		order[start] = low[start] = visited++;
+		component.push_back(start);
+		onStack[start] = true;
+		path.push_back(std::make_pair(start, first[start]));
+		while (!path.empty()) {
+			size_t node = path.back().first;
+			if (path.back().second < first[node + 1]) {
+				size_t next = targets[path.back().second++];
+				if (order[next] == UNVISITED) {
+					order[next] = low[next] = visited++;
+					component.push_back(next);
+					onStack[next] = true;
+					path.push_back(std::make_pair(next, first[next]));
+				}
+				else if (onStack[next]) {
+					low[node] = std::min(low[node], order[next]);
+				}
+				continue;
+			}
+			path.pop_back();
+			if (!path.empty()) {
+				low[path.back().first] = std::min(low[path.back().first], low[node]);
+			}
+			if (low[node] != order[node]) {
+				continue;
+			}
+			bool cycle = component.back() != node
+				|| std::find(targets.begin() + first[node], targets.begin() + first[node + 1], node) != targets.begin() + first[node + 1];
+			size_t member;
+			do {
+				member = component.back();
+				component.pop_back();
+				onStack[member] = false;
+				inCycle[member] = cycle;
+			} while (member != node);
+		}
+	}
+
+	std::vector<std::pair<unsigned, unsigned>> cyclic;
+	for (size_t i = 0; i < formulas.size(); i++) {
+		(inCycle[i] ? cyclic : acyclic).push_back(formulas[i]);
+	}
+	return cyclic;
+}
+
+/**
+ * @brief Makes room for the edges of a number of formulas.
+ * @details Most formulas read cells no other formula reads, so the reverse edges get as much room as the forward ones.
+ * @param formulas The expected number of formula cells.
+ */
+void DependencyGraph::reserve(const size_t formulas) {
+	this->precedents.reserve(formulas);
+	this->readers.reserve(formulas);
+}
+
+/**
+ * @brief Removes all edges.
+ */
+void DependencyGraph::clear() {
+	this->precedents.clear();
+	this->readers.clear();
+	this->rangePrecedents.clear();
+	this->rangeReaders.clear();
+}
+
+/**
+ * @brief Sorts the edges of a column and rebuilds its tree.
+ * @details Only the edges appended since the last rebuild are sorted, then merged into the others,
+ * and removing edges keeps the rest in order, so a rebuild after an edit is linear.
+ * @param column The column.
+ */
+void DependencyGraph::index(RangeColumn& column) {
+	auto byTop = [](const RangeEdge& first, const RangeEdge& second) { return first.top < second.top; };
+	std::sort(column.edges.begin() + column.sorted, column.edges.end(), byTop);
+	std::inplace_merge(column.edges.begin(), column.edges.begin() + column.sorted, column.edges.end(), byTop);
+	column.sorted = column.edges.size();
+	column.reach.resize(column.edges.size());
+	reach(column, 0, column.edges.size());
+}
+
+/**
+ * @brief Computes the last row covered by the edges of a slice of a column, for every root in it.
+ * @details The root of a slice is its middle edge, so the recursion is only as deep as the tree.
+ * @param column The column, with sorted edges.
+ * @param begin The first edge of the slice.
+ * @param end One past the last edge of the slice.
+ * @return The last row covered by the slice, INT_MIN for an empty slice.
+ */
+int DependencyGraph::reach(RangeColumn& column, const size_t begin, const size_t end) {
+	if (begin >= end) {
+		return INT_MIN;
+	}
+	size_t middle = begin + (end - begin) / 2;
+	int last = std::max(column.edges[middle].bottom, std::max(reach(column, begin, middle), reach(column, middle + 1, end)));
+	column.reach[middle] = last;
+	return last;
+}
+
+/**
+ * @brief Collects the formulas that read a cell, through a cell reference or a range.
+ * @details The interval tree of the column is walked with a work list. A slice is skipped if none
+ * of its ranges reaches down to the row, and the later half of a slice if its root starts below
+ * the row, so only the paths to the ranges containing the cell are visited.
+ * @param cell The key of the cell.
+ * @param found Receives the keys of the formulas, a formula may be listed twice.
+ */
+void DependencyGraph::readersOf(const uint64_t cell, std::vector<uint64_t>& found) const {
+	auto direct = this->readers.find(cell);
+	if (direct != this->readers.end()) {
+		found.insert(found.end(), direct->second.begin(), direct->second.end());
+	}
+	auto column = this->rangeReaders.find(static_cast<unsigned>(cell));
+	if (column == this->rangeReaders.end()) {
+		return;
+	}
+	RangeColumn& ranges = column->second;
+	if (ranges.reach.size() != ranges.edges.size() || ranges.sorted != ranges.edges.size()) {
+		index(ranges);
+	}
+	int row = static_cast<int>(cell >> 32);
+	std::pair<size_t, size_t> pending[2 * 64];
+	size_t count = 0;
+	pending[count++] = std::make_pair(size_t(0), ranges.edges.size());
+	while (count > 0) {
+		size_t begin = pending[count - 1].first;
+		size_t end = pending[count - 1].second;
+		count--;
+		if (begin >= end) {
+			continue;
+		}
+		size_t middle = begin + (end - begin) / 2;
+		if (ranges.reach[middle] < row) {
+			continue;
+		}
+		if (ranges.edges[middle].top <= row) {
+			if (row <= ranges.edges[middle].bottom) {
+				found.push_back(ranges.edges[middle].formula);
+			}
+			pending[count++] = std::make_pair(middle + 1, end);
+		}
+		pending[count++] = std::make_pair(begin, middle);
+	}
+}
+
+/**
+ * @brief Collects the edges between the formulas of a group.
+ * @details Edges of ranges are found by looking up the rows of every covered column in an index
+ * of the group sorted by column and row, which is only built if a formula of the group reads a range.
+ * @param formulas The row and column indices of the formulas of the group.
+ * @param first Receives the offset of the edges of every formula in `targets`, and the end of the last one.
+ * @param targets Receives the group indices of the formulas every formula reads.
+ */
+void DependencyGraph::edgesWithin(const std::vector<std::pair<unsigned, unsigned>>& formulas, std::vector<size_t>& first,
+	std::vector<size_t>& targets) const {
+	std::unordered_map<uint64_t, size_t> index;
+	index.reserve(formulas.size());
+	for (size_t i = 0; i < formulas.size(); i++) {
+		index.emplace(key(formulas[i].first, formulas[i].second), i);
+	}
+	std::vector<std::pair<uint64_t, size_t>> byColumn;
+	first.assign(1, 0);
+	first.reserve(formulas.size() + 1);
+	targets.clear();
+	for (size_t i = 0; i < formulas.size(); i++) {
+		uint64_t formula = key(formulas[i].first, formulas[i].second);
+		auto found = this->precedents.find(formula);
+		if (found != this->precedents.end()) {
+			for (size_t j = 0; j < found->second.size(); j++) {
+				auto target = index.find(found->second[j]);
+				if (target != index.end()) {
+					targets.push_back(target->second);
+				}
+			}
+		}
+		auto ranges = this->rangePrecedents.find(formula);
+		if (ranges != this->rangePrecedents.end()) {
+			if (byColumn.empty()) {
+				byColumn.reserve(formulas.size());
+				for (size_t j = 0; j < formulas.size(); j++) {
+					byColumn.push_back(std::make_pair(key(formulas[j].second, formulas[j].first), j));
+				}
+				std::sort(byColumn.begin(), byColumn.end());
+			}
+			for (size_t j = 0; j < ranges->second.size(); j++) {
+				const CellRange& range = ranges->second[j];
+				for (int column = range.left; column <= range.right; column++) {
+					auto cell = std::lower_bound(byColumn.begin(), byColumn.end(), std::make_pair(key(column, range.top), size_t(0)));
+					for (; cell != byColumn.end() && cell->first <= key(column, range.bottom); ++cell) {
+						targets.push_back(cell->second);
+					}
+				}
+			}
+		}
+		first.push_back(targets.size());
+	}
+}
+
+/**
+ * @brief Packs the position of a cell into a single key.
+ * @param row The row index of the cell.
+ * @param col The column index of the cell.
+ * @return The key of the cell, the row in the high and the column in the low 32 bits.
+ */
+uint64_t DependencyGraph::key(const unsigned row, const unsigned col) {
+	return static_cast<uint64_t>(row) << 32 | col;
+}
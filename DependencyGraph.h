@@ -0,0 +1,149 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "CellRange.h"
+
+/**
+ * @class DependencyGraph
+ * @brief Records which cells every formula reads and which formulas read every cell.
+ *
+ * Every formula cell has forward edges to the cells of its operands, and every referenced cell
+ * has reverse edges to the formulas reading it. The reverse edges give the cells that have to be
+ * recomputed after an edit without looking at the rest of the table. Ranges are kept whole, with
+ * a reverse edge from every column they cover, so a formula over a million cells costs one edge
+ * per column. The range edges of a column form an interval tree over their rows, so finding the
+ * ranges that contain a cell does not visit the others.
+ */
+class DependencyGraph {
+public:
+	/**
+	 * @brief Constructs an empty DependencyGraph object.
+	 */
+	DependencyGraph();
+
+	/**
+	 * @brief Sets the cells a formula cell reads, replacing its previous edges.
+	 * @param row The row index of the formula cell.
+	 * @param col The column index of the formula cell.
+	 * @param precedents The row and column indices of the cells the formula reads.
+	 * @param ranges The ranges the formula reads, clipped to the table.
+	 */
+	void link(const unsigned row, const unsigned col, const std::vector<std::pair<int, int>>& precedents,
+		const std::vector<CellRange>& ranges);
+
+	/**
+	 * @brief Removes the edges of a cell that no longer holds a formula.
+	 * @param row The row index of the cell.
+	 * @param col The column index of the cell.
+	 */
+	void unlink(const unsigned row, const unsigned col);
+
+	/**
+	 * @brief Collects the formulas that read a cell, directly or through other formulas.
+	 * @param row The row index of the cell.
+	 * @param col The column index of the cell.
+	 * @return The row and column indices of the dependent formulas, in no particular order.
+	 */
+	std::vector<std::pair<unsigned, unsigned>> dependents(const unsigned row, const unsigned col) const;
+
+	/**
+	 * @brief Groups formulas into levels that can each be evaluated in parallel.
+	 * @param formulas The row and column indices of the formulas to group, formulas outside of them count as evaluated.
+	 * @param blocked Receives the formulas that are part of a cycle of the group or read one.
+	 * @return The levels, every formula only reads formulas of earlier levels.
+	 */
+	std::vector<std::vector<std::pair<unsigned, unsigned>>> levels(const std::vector<std::pair<unsigned, unsigned>>& formulas,
+		std::vector<std::pair<unsigned, unsigned>>& blocked) const;
+
+	/**
+	 * @brief Finds the formulas that read themselves, directly or through other formulas.
+	 * @param formulas The row and column indices of the formulas to search, only edges between them are followed.
+	 * @param acyclic Receives the formulas that are not part of a cycle.
+	 * @return The formulas that are part of a cycle.
+	 */
+	std::vector<std::pair<unsigned, unsigned>> cycles(const std::vector<std::pair<unsigned, unsigned>>& formulas,
+		std::vector<std::pair<unsigned, unsigned>>& acyclic) const;
+
+	/**
+	 * @brief Makes room for the edges of a number of formulas.
+	 * @param formulas The expected number of formula cells.
+	 */
+	void reserve(const size_t formulas);
+
+	/**
+	 * @brief Removes all edges.
+	 */
+	void clear();
+
+private:
+	/**
+	 * @struct RangeEdge
+	 * @brief The rows of a range over one column, with the formula reading it.
+	 */
+	struct RangeEdge {
+		int top; /**< The first row of the range. */
+		int bottom; /**< The last row of the range. */
+		uint64_t formula; /**< The key of the formula reading the range. */
+	};
+
+	/**
+	 * @struct RangeColumn
+	 * @brief The range edges of one column, kept as an implicit interval tree.
+	 *
+	 * The edges are sorted by their top row and the middle of every slice of the array is the root
+	 * of that slice, `reach` holding the last row covered by any edge of the slice. New edges are
+	 * appended and the tree is rebuilt by the first lookup after a change.
+	 */
+	struct RangeColumn {
+		std::vector<RangeEdge> edges; /**< The edges, sorted by top row up to `sorted`. */
+		std::vector<int> reach; /**< The last row covered by the slice rooted at every edge, empty while the tree is out of date. */
+		size_t sorted = 0; /**< The number of leading edges that are in order. */
+	};
+
+	/**
+	 * @brief Sorts the edges of a column and rebuilds its tree.
+	 * @param column The column.
+	 */
+	static void index(RangeColumn& column);
+
+	/**
+	 * @brief Computes the last row covered by the edges of a slice of a column, for every root in it.
+	 * @param column The column, with sorted edges.
+	 * @param begin The first edge of the slice.
+	 * @param end One past the last edge of the slice.
+	 * @return The last row covered by the slice.
+	 */
+	static int reach(RangeColumn& column, const size_t begin, const size_t end);
+
+	/**
+	 * @brief Collects the formulas that read a cell, through a cell reference or a range.
+	 * @param cell The key of the cell.
+	 * @param found Receives the keys of the formulas, a formula may be listed twice.
+	 */
+	void readersOf(const uint64_t cell, std::vector<uint64_t>& found) const;
+
+	/**
+	 * @brief Collects the edges between the formulas of a group.
+	 * @param formulas The row and column indices of the formulas of the group.
+	 * @param first Receives the offset of the edges of every formula in `targets`, and the end of the last one.
+	 * @param targets Receives the group indices of the formulas every formula reads.
+	 */
+	void edgesWithin(const std::vector<std::pair<unsigned, unsigned>>& formulas, std::vector<size_t>& first,
+		std::vector<size_t>& targets) const;
+
+	/**
+	 * @brief Packs the position of a cell into a single key.
+	 * @param row The row index of the cell.
+	 * @param col The column index of the cell.
+	 * @return The key of the cell.
+	 */
+	static uint64_t key(const unsigned row, const unsigned col);
+
+	std::unordered_map<uint64_t, std::vector<uint64_t>> precedents; /**< The cells every formula reads. */
+	std::unordered_map<uint64_t, std::vector<uint64_t>> readers; /**< The formulas reading every cell. */
+	std::unordered_map<uint64_t, std::vector<CellRange>> rangePrecedents; /**< The ranges every formula reads. */
+	mutable std::unordered_map<unsigned, RangeColumn> rangeReaders; /**< The ranges read over every column, indexed by the first lookup after a change, so lookups must not run concurrently. */
+};
@@ -1,4 +1,5 @@
 #include "DoubleData.h"
+#include <charconv>
 
 /**
  * @brief Default constructor for DoubleData.
@@ -31,6 +32,32 @@ std::string DoubleData::stringifyFile() const
 	return std::to_string(this->val);
 }
 
+/**
+ * @brief Writes the double value into a caller-supplied buffer.
+ * @details The text is the same as the one of stringify(), fixed notation with 6 decimals produced with std::to_chars.
+ * @param buffer The buffer to write to.
+ * @param size The size of the buffer.
+ * @return The length of the string representation.
+ */
+size_t DoubleData::format(char* buffer, const size_t size) const
+{
+	char text[FORMAT_BUFFER_SIZE];
+	std::to_chars_result result = std::to_chars(text, text + sizeof(text), this->val, std::chars_format::fixed, 6);
+	return copyText(buffer, size, text, result.ptr - text);
+}
+
+/**
+ * @brief Writes the double value for file output into a caller-supplied buffer.
+ * @details The file holds the same text as the console, see format().
+ * @param buffer The buffer to write to.
+ * @param size The size of the buffer.
+ * @return The length of the string representation.
+ */
+size_t DoubleData::formatFile(char* buffer, const size_t size) const
+{
+	return this->format(buffer, size);
+}
+
 /**
  * @brief Retrieves the data type of the DoubleData object.
  * @return The data type of the object (DOUBLE).
@@ -39,6 +66,17 @@ DataType DoubleData::getType() const {
 	return this->type;
 }
 
+/**
+ * @brief Evaluates the double value to a typed number.
+ * @return The value as a DOUBLE_VALUE.
+ */
+Value DoubleData::evaluate(const Table&) const {
+	Value value;
+	value.type = DOUBLE_VALUE;
+	value.dval = this->val;
+	return value;
+}
+
 /**
  * @brief Retrieves the double value stored in DoubleData.
  * @return The double value.
@@ -30,12 +30,35 @@ public:
 	 */
 	virtual std::string stringifyFile() const override;
 
+	/**
+	 * @brief Writes the string representation of the DoubleData object into a caller-supplied buffer.
+	 * @param buffer The buffer to write to.
+	 * @param size The size of the buffer.
+	 * @return The length of the whole string representation.
+	 */
+	virtual size_t format(char* buffer, const size_t size) const override;
+
+	/**
+	 * @brief Writes the string representation of the DoubleData object for file output into a caller-supplied buffer.
+	 * @param buffer The buffer to write to.
+	 * @param size The size of the buffer.
+	 * @return The length of the whole string representation for file output.
+	 */
+	virtual size_t formatFile(char* buffer, const size_t size) const override;
+
 	/**
 	 * @brief Retrieves the data type of the DoubleData object.
 	 * @return The data type of the DoubleData object (DataType::DOUBLE).
 	 */
 	virtual DataType getType() const override;
 
+	/**
+	 * @brief Evaluates the DoubleData object to a typed number.
+	 * @param table Unused, the value does not depend on other cells.
+	 * @return The value as a DOUBLE_VALUE.
+	 */
+	virtual Value evaluate(const Table& table) const override;
+
 	/**
 	 * @brief Retrieves the value of the DoubleData object.
 	 * @return The value of the DoubleData object.
@@ -0,0 +1,20 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "Instruction.h"
+
+/**
+ * @struct Expression
+ * @brief A compiled expression, shared by all formulas that are written the same way relative to their cells.
+ *
+ * The cell references are stored as offsets from the formula, so "=R5C0 + R5C1" in row 5 and
+ * "=R6C0 + R6C1" in row 6 compile to the same expression. Ranges keep their absolute coordinates.
+ */
+struct Expression {
+	std::vector<Instruction> code; /**< The instructions as parsed, in postfix order. */
+	std::vector<Instruction> folded; /**< The instructions with constant subexpressions folded, empty if nothing could be folded. */
+	size_t stackDepth = 0; /**< The deepest value stack the evaluated instructions need. */
+	size_t references = 0; /**< The number of formulas using the expression. */
+	size_t index = 0; /**< The position of the expression in its pool. */
+	bool relative = false; /**< Whether the expression reads single cells, so the formulas sharing it may read different cells. */
+};
@@ -0,0 +1,247 @@
+#include "ExpressionPool.h"
+#include "FormulaData.h"
+#include <functional>
+#include <new>
+
+/**
+ * @brief Default constructor for ExpressionPool.
+ * @details Initializes a pool without expressions, the lookup table is allocated on demand.
+ */
+ExpressionPool::ExpressionPool() : used(0) {}
+
+/**
+ * @brief Stores an expression, or adds a reference to an interned one with the same instructions.
+ * @details The table is probed linearly from the slot of the hash and only slots with the same
+ * hash are compared instruction by instruction. A new expression is folded once, the formulas
+ * sharing it later cost a lookup.
+ * @param code The instructions, with the cell references made relative by FormulaData::makeRelative().
+ * @return The stored expression.
+ * @throws std::bad_alloc If the expression could not be stored.
+ */
+const Expression* ExpressionPool::intern(std::vector<Instruction> code) {
+	if ((this->expressions.size() + 1) * 2 > this->slots.size()) {
+		this->grow();
+	}
+	size_t hash = ExpressionPool::hash(code);
+	size_t mask = this->slots.size() - 1;
+	size_t i = hash & mask;
+	for (; this->slots[i].expression != nullptr; i = (i + 1) & mask) {
+		if (this->slots[i].hash == hash && equal(this->slots[i].expression->code, code)) {
+			this->slots[i].expression->references++;
+			return this->slots[i].expression;
+		}
+	}
+
+	std::vector<Instruction> folded = FormulaData::fold(code);
+	size_t stackDepth = FormulaData::stackDepth(folded.empty() ? code : folded);
+	void* memory = this->arena.allocate(sizeof(Expression));
+	try {
+		this->expressions.push_back(nullptr);
+	}
+	catch (std::bad_alloc& e) {
+		this->arena.deallocate(memory, sizeof(Expression));
+		throw;
+	}
+	Expression* expression = new (memory) Expression();
+	expression->code = std::move(code);
+	expression->folded = std::move(folded);
+	expression->stackDepth = stackDepth;
+	expression->references = 1;
+	expression->index = this->expressions.size() - 1;
+	expression->relative = readsCells(expression->code);
+	this->expressions.back() = expression;
+	this->slots[i].hash = hash;
+	this->slots[i].expression = expression;
+	this->used += bytes(*expression);
+	return expression;
+}
+
+/**
+ * @brief Adds a reference to an expression of the pool.
+ * @details Used when a formula is known to share an expression without looking it up again.
+ * @param expression The expression returned by intern().
+ */
+void ExpressionPool::retain(const Expression* expression) {
+	this->expressions[expression->index]->references++;
+}
+
+/**
+ * @brief Drops a reference to an expression, freeing it with the last one.
+ * @details The last expression of the pool takes the position of the freed one.
+ * @param expression The expression returned by intern().
+ */
+void ExpressionPool::release(const Expression* expression) {
+	if (expression == nullptr) {
+		return;
+	}
+	Expression* stored = this->expressions[expression->index];
+	if (--stored->references > 0) {
+		return;
+	}
+	this->unlink(stored);
+	this->expressions.back()->index = stored->index;
+	this->expressions[stored->index] = this->expressions.back();
+	this->expressions.pop_back();
+	this->used -= bytes(*stored);
+	stored->~Expression();
+	this->arena.deallocate(stored, sizeof(Expression));
+}
+
+/**
+ * @brief Retrieves an expression by its position in the pool.
+ * @details The positions are dense, freeing an expression moves the last one into its place.
+ * @param index The position, less than size().
+ * @return The expression.
+ */
+const Expression* ExpressionPool::get(const size_t index) const {
+	return this->expressions[index];
+}
+
+/**
+ * @brief Retrieves the number of expressions in the pool.
+ * @return The number of expressions.
+ */
+size_t ExpressionPool::size() const {
+	return this->expressions.size();
+}
+
+/**
+ * @brief Computes the memory used by the pool.
+ * @return The approximate number of bytes held by the expressions and the lookup table.
+ */
+size_t ExpressionPool::memoryUsage() const {
+	return this->used + this->arena.memoryUsage() + this->expressions.capacity() * sizeof(Expression*)
+		+ this->slots.capacity() * sizeof(Slot);
+}
+
+/**
+ * @brief Removes all expressions from the pool.
+ * @details The expressions are destroyed, then the arena is released in one go.
+ */
+void ExpressionPool::clear() {
+	for (size_t i = 0; i < this->expressions.size(); i++) {
+		this->expressions[i]->~Expression();
+	}
+	std::vector<Expression*>().swap(this->expressions);
+	std::vector<Slot>().swap(this->slots);
+	this->arena.release();
+	this->used = 0;
+}
+
+/**
+ * @brief Destructor for ExpressionPool.
+ */
+ExpressionPool::~ExpressionPool() {
+	this->clear();
+}
+
+/**
+ * @brief Checks whether an expression reads single cells.
+ * @details The cells are given relative to the formula, so two formulas sharing such an
+ * expression read different cells unless they are the same formula.
+ * @param code The instructions.
+ * @return `true` if one of the instructions pushes a cell, `false` otherwise.
+ */
+bool ExpressionPool::readsCells(const std::vector<Instruction>& code) {
+	for (const Instruction& instruction : code) {
+		if (instruction.op == OP_PUSH_CELL) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Hashes parsed instructions.
+ * @details The fields are combined one by one and the result is mixed, so the low bits used to
+ * pick a slot depend on all of them.
+ * @param code The instructions.
+ * @return The hash of every field of every instruction.
+ */
+size_t ExpressionPool::hash(const std::vector<Instruction>& code) {
+	size_t hash = code.size();
+	for (const Instruction& instruction : code) {
+		const int fields[] = { instruction.op, instruction.row, instruction.col,
+			instruction.range.top, instruction.range.left, instruction.range.bottom, instruction.range.right };
+		for (int field : fields) {
+			hash = hash * 31 + static_cast<unsigned>(field);
+		}
+		hash = hash * 31 + std::hash<double>()(instruction.number);
+	}
+	hash ^= hash >> 31;
+	hash *= 0x9E3779B97F4A7C15ull;
+	return hash ^ (hash >> 29);
+}
+
+/**
+ * @brief Compares two sequences of parsed instructions.
+ * @param left The first instructions.
+ * @param right The second instructions.
+ * @return `true` if every field of every instruction is equal, `false` otherwise.
+ */
+bool ExpressionPool::equal(const std::vector<Instruction>& left, const std::vector<Instruction>& right) {
+	if (left.size() != right.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < left.size(); i++) {
+		const Instruction& a = left[i];
+		const Instruction& b = right[i];
+		if (a.op != b.op || a.row != b.row || a.col != b.col || a.number != b.number || a.range.top != b.range.top
+			|| a.range.left != b.range.left || a.range.bottom != b.range.bottom || a.range.right != b.range.right) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Computes the memory held by the instructions of an expression.
+ * @param expression The expression.
+ * @return The number of bytes.
+ */
+size_t ExpressionPool::bytes(const Expression& expression) {
+	return (expression.code.capacity() + expression.folded.capacity()) * sizeof(Instruction);
+}
+
+/**
+ * @brief Removes an expression from the lookup table.
+ * @details The slots after the freed one are shifted back if their probe passed it, so no lookup
+ * ever stops early at the hole.
+ * @param expression The expression.
+ */
+void ExpressionPool::unlink(const Expression* expression) {
+	size_t mask = this->slots.size() - 1;
+	size_t hole = hash(expression->code) & mask;
+	while (this->slots[hole].expression != expression) {
+		hole = (hole + 1) & mask;
+	}
+	for (size_t j = (hole + 1) & mask; this->slots[j].expression != nullptr; j = (j + 1) & mask) {
+		size_t home = this->slots[j].hash & mask;
+		bool reachesHole = hole <= j ? home <= hole || home > j : home <= hole && home > j;
+		if (reachesHole) {
+			this->slots[hole] = this->slots[j];
+			hole = j;
+		}
+	}
+	this->slots[hole] = Slot();
+}
+
+/**
+ * @brief Doubles the lookup table, moving every slot to its new position.
+ * @details Only the stored hashes are read, the expressions are not touched.
+ */
+void ExpressionPool::grow() {
+	std::vector<Slot> old(this->slots.empty() ? MIN_SLOTS : this->slots.size() * 2);
+	old.swap(this->slots);
+	size_t mask = this->slots.size() - 1;
+	for (size_t i = 0; i < old.size(); i++) {
+		if (old[i].expression == nullptr) {
+			continue;
+		}
+		size_t j = old[i].hash & mask;
+		while (this->slots[j].expression != nullptr) {
+			j = (j + 1) & mask;
+		}
+		this->slots[j] = old[i];
+	}
+}
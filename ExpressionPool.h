@@ -0,0 +1,133 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "Expression.h"
+#include "Arena.h"
+
+/**
+ * @class ExpressionPool
+ * @brief Stores the compiled expressions of formulas, once for all formulas written the same way.
+ *
+ * Expressions are interned: formulas whose instructions are equal, with their cell references
+ * relative to the formula, get the same expression, so a formula copied down half a million rows
+ * is folded and stored once. Formulas sharing an expression without cell references read the same
+ * ranges and compute the same value. An expression is freed once the last formula referring to it
+ * releases it. The expressions are kept in an arena and found through an open addressing table of
+ * hashes and pointers, so growing the table never touches the expressions themselves.
+ */
+class ExpressionPool {
+public:
+	/**
+	 * @brief Constructs an empty ExpressionPool object.
+	 */
+	ExpressionPool();
+
+	ExpressionPool(const ExpressionPool&) = delete; /**< Disable copy constructor. */
+	ExpressionPool& operator=(const ExpressionPool&) = delete; /**< Disable assignment operator. */
+
+	/**
+	 * @brief Stores an expression, or adds a reference to an interned one with the same instructions.
+	 * @param code The instructions, with the cell references made relative by FormulaData::makeRelative().
+	 * @return The stored expression.
+	 * @throws std::bad_alloc If the expression could not be stored.
+	 */
+	const Expression* intern(std::vector<Instruction> code);
+
+	/**
+	 * @brief Adds a reference to an expression of the pool.
+	 * @param expression The expression returned by intern().
+	 */
+	void retain(const Expression* expression);
+
+	/**
+	 * @brief Drops a reference to an expression, freeing it with the last one.
+	 * @param expression The expression returned by intern().
+	 */
+	void release(const Expression* expression);
+
+	/**
+	 * @brief Retrieves an expression by its position in the pool.
+	 * @param index The position, less than size().
+	 * @return The expression.
+	 */
+	const Expression* get(const size_t index) const;
+
+	/**
+	 * @brief Retrieves the number of expressions in the pool.
+	 * @return The number of expressions.
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief Computes the memory used by the pool.
+	 * @return The approximate number of bytes held by the expressions and the lookup table.
+	 */
+	size_t memoryUsage() const;
+
+	/**
+	 * @brief Removes all expressions from the pool.
+	 */
+	void clear();
+
+	/**
+	 * @brief Destructs the ExpressionPool object, freeing all expressions.
+	 */
+	~ExpressionPool();
+
+private:
+	/**
+	 * @struct Slot
+	 * @brief An entry of the lookup table.
+	 */
+	struct Slot {
+		size_t hash = 0; /**< The hash of the parsed instructions of the expression. */
+		Expression* expression = nullptr; /**< The expression, nullptr for an empty slot. */
+	};
+
+	/**
+	 * @brief Checks whether an expression reads single cells.
+	 * @param code The instructions.
+	 * @return `true` if one of the instructions pushes a cell, `false` otherwise.
+	 */
+	static bool readsCells(const std::vector<Instruction>& code);
+
+	/**
+	 * @brief Hashes parsed instructions.
+	 * @param code The instructions.
+	 * @return The hash of every field of every instruction.
+	 */
+	static size_t hash(const std::vector<Instruction>& code);
+
+	/**
+	 * @brief Compares two sequences of parsed instructions.
+	 * @param left The first instructions.
+	 * @param right The second instructions.
+	 * @return `true` if every field of every instruction is equal, `false` otherwise.
+	 */
+	static bool equal(const std::vector<Instruction>& left, const std::vector<Instruction>& right);
+
+	/**
+	 * @brief Computes the memory held by the instructions of an expression.
+	 * @param expression The expression.
+	 * @return The number of bytes.
+	 */
+	static size_t bytes(const Expression& expression);
+
+	/**
+	 * @brief Removes an expression from the lookup table.
+	 * @param expression The expression.
+	 */
+	void unlink(const Expression* expression);
+
+	/**
+	 * @brief Doubles the lookup table, moving every slot to its new position.
+	 */
+	void grow();
+
+	static const size_t MIN_SLOTS = 64; /**< The size of the lookup table once the first expression is stored. */
+
+	std::vector<Expression*> expressions; /**< All stored expressions, each knows its position. */
+	std::vector<Slot> slots; /**< The lookup table of the expressions, its size is a power of two and at most half is used. */
+	size_t used; /**< The memory held by the instructions of the stored expressions. */
+	Arena arena; /**< The memory of the expressions. */
+};
@@ -0,0 +1,209 @@
+#include "FileWriter.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+/**
+ * @brief Writes the directory entries of the directory holding a file to disk.
+ *
+ * A rename is only durable once the directory itself is synced. Failing to sync it leaves the
+ * new file in place, so the result is ignored.
+ *
+ * @param filename The name of the file.
+ */
+static void syncDirectory(const std::string& filename) {
+    size_t slash = filename.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : filename.substr(0, slash == 0 ? 1 : slash);
+    int handle = open(directory.c_str(), O_RDONLY);
+    if (handle >= 0) {
+        fsync(handle);
+        close(handle);
+    }
+}
+#endif
+
+/**
+ * @brief Constructs a FileWriter object for the given file.
+ *
+ * The temporary file is created next to the target, so it is on the same file system and the
+ * final rename cannot turn into a copy. Its name is the target name with a unique suffix and it
+ * is created exclusively, so an existing file or symbolic link of that name is never opened and
+ * two saves of the same file do not share it. The new file gets the permissions of the file it replaces, and a symbolic link
+ * is followed so the file it points to is replaced rather than the link. A target that exists but
+ * is not a regular file, like /dev/null or a pipe, cannot be renamed over and is written in place.
+ *
+ * @param filename The name of the file to replace.
+ */
+FileWriter::FileWriter(const std::string& filename) : target(filename), file(-1), good(false) {
+#ifdef _WIN32
+    for (unsigned attempt = 0; attempt < MAX_TEMPORARY_ATTEMPTS && this->file == -1; attempt++) {
+        this->temporary = this->target + "." + std::to_string(GetCurrentProcessId()) + "." + std::to_string(attempt) + ".tmp";
+        HANDLE handle = CreateFileA(this->temporary.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle != INVALID_HANDLE_VALUE) {
+            this->file = reinterpret_cast<intptr_t>(handle);
+        }
+        else if (GetLastError() != ERROR_FILE_EXISTS) {
+            break;
+        }
+    }
+#else
+    char* resolved = realpath(filename.c_str(), nullptr);
+    if (resolved != nullptr) {
+        this->target = resolved;
+        std::free(resolved);
+    }
+    struct stat info;
+    bool exists = stat(this->target.c_str(), &info) == 0;
+    int handle = -1;
+    if (exists && !S_ISREG(info.st_mode)) {
+        this->temporary.clear();
+        handle = open(this->target.c_str(), O_WRONLY | O_TRUNC);
+    }
+    else {
+        std::string pattern = this->target + ".XXXXXX";
+        handle = mkstemp(&pattern[0]);
+        if (handle >= 0) {
+            this->temporary = pattern;
+            mode_t mask = umask(0);
+            umask(mask);
+            fchmod(handle, exists ? info.st_mode & 07777 : 0666 & ~mask);
+        }
+    }
+    if (handle >= 0) {
+        this->file = handle;
+    }
+#endif
+    this->good = this->file != -1;
+    if (!this->good) {
+        this->temporary.clear();
+    }
+}
+
+/**
+ * @brief Checks if the temporary file was created.
+ *
+ * @return True if the file is open, False otherwise.
+ */
+bool FileWriter::is_open() const {
+    return this->file != -1;
+}
+
+/**
+ * @brief Appends data to the temporary file.
+ *
+ * Short writes are continued until all bytes are written. After a failed write, like on a full
+ * disk, nothing more is written and commit() leaves the target alone.
+ *
+ * @param data The bytes to write.
+ * @param size The number of bytes.
+ * @return True if every write so far succeeded, False otherwise.
+ */
+bool FileWriter::write(const char* data, const size_t size) {
+    size_t written = 0;
+    while (this->good && written < size) {
+#ifdef _WIN32
+        DWORD chunk = static_cast<DWORD>(size - written < (1u << 30) ? size - written : (1u << 30));
+        DWORD count = 0;
+        if (!WriteFile(reinterpret_cast<HANDLE>(this->file), data + written, chunk, &count, nullptr) || count == 0) {
+            this->good = false;
+        }
+#else
+        ssize_t count = ::write(static_cast<int>(this->file), data + written, size - written);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            this->good = false;
+        }
+#endif
+        else {
+            written += static_cast<size_t>(count);
+        }
+    }
+    return this->good;
+}
+
+/**
+ * @brief Replaces the target with the temporary file.
+ *
+ * The temporary file is synced and closed before it is renamed, so the target is either the old
+ * file or the complete new one, even after a crash. If any step fails the temporary file is
+ * removed and the target is untouched.
+ *
+ * @return True if the target was replaced, False otherwise.
+ */
+bool FileWriter::commit() {
+    if (!this->good) {
+        this->discard();
+        return false;
+    }
+#ifdef _WIN32
+    HANDLE handle = reinterpret_cast<HANDLE>(this->file);
+    bool synced = FlushFileBuffers(handle) != 0;
+    bool closed = CloseHandle(handle) != 0;
+    this->file = -1;
+    if (!synced || !closed || !MoveFileExA(this->temporary.c_str(), this->target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        this->discard();
+        return false;
+    }
+#else
+    int handle = static_cast<int>(this->file);
+    if (this->temporary.empty()) {
+        this->file = -1;
+        return close(handle) == 0;
+    }
+    bool synced = fsync(handle) == 0;
+    bool closed = close(handle) == 0;
+    this->file = -1;
+    if (!synced || !closed || std::rename(this->temporary.c_str(), this->target.c_str()) != 0) {
+        this->discard();
+        return false;
+    }
+    syncDirectory(this->target);
+#endif
+    this->temporary.clear();
+    return true;
+}
+
+/**
+ * @brief Closes the temporary file, if it is still open, and removes it.
+ */
+void FileWriter::discard() {
+    this->good = false;
+#ifdef _WIN32
+    if (this->file != -1) {
+        CloseHandle(reinterpret_cast<HANDLE>(this->file));
+    }
+    if (!this->temporary.empty()) {
+        DeleteFileA(this->temporary.c_str());
+    }
+#else
+    if (this->file != -1) {
+        close(static_cast<int>(this->file));
+    }
+    if (!this->temporary.empty()) {
+        unlink(this->temporary.c_str());
+    }
+#endif
+    this->file = -1;
+    this->temporary.clear();
+}
+
+/**
+ * @brief Destructor for the FileWriter class.
+ *
+ * A writer that was never committed removes its temporary file, the target keeps its old contents.
+ */
+FileWriter::~FileWriter() {
+    this->discard();
+}
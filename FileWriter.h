@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class FileWriter
+ * @brief Replaces a file atomically with the data written to it.
+ *
+ * The data goes to a uniquely named temporary file next to the target, which only takes the place of the
+ * target once commit() has written it to disk. Until then, and for good if anything fails, the
+ * target keeps its old contents. The writer does not buffer, the data should be handed to it
+ * in large blocks. A target that is not a regular file, like a device, is written in place.
+ */
+class FileWriter {
+public:
+    /**
+     * @brief Constructs a FileWriter object and creates the temporary file.
+     * @param filename The name of the file to replace.
+     */
+    explicit FileWriter(const std::string& filename);
+
+    FileWriter(const FileWriter&) = delete; /**< Disable copy constructor. */
+    FileWriter& operator=(const FileWriter&) = delete; /**< Disable assignment operator. */
+
+    /**
+     * @brief Checks if the temporary file was created.
+     * @return `true` if the file is open, `false` otherwise.
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Appends data to the temporary file.
+     * @param data The bytes to write.
+     * @param size The number of bytes.
+     * @return `true` if every write so far succeeded, `false` otherwise.
+     */
+    bool write(const char* data, const size_t size);
+
+    /**
+     * @brief Writes the temporary file to disk and renames it over the target.
+     * @return `true` if the target was replaced, `false` if it was left as it was.
+     */
+    bool commit();
+
+    /**
+     * @brief Destructs the FileWriter object, removing the temporary file if it was not committed.
+     */
+    ~FileWriter();
+
+private:
+    static const unsigned MAX_TEMPORARY_ATTEMPTS = 100; /**< The number of temporary file names tried before giving up, on Windows. */
+
+    /**
+     * @brief Closes the temporary file and removes it.
+     */
+    void discard();
+
+    std::string target; /**< The name of the file to replace. */
+    std::string temporary; /**< The name of the temporary file, empty if the target is written in place. */
+    intptr_t file; /**< The descriptor or handle of the temporary file, -1 if it is not open. */
+    bool good; /**< Whether every operation so far succeeded. */
+};
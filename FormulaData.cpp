@@ -1,52 +1,181 @@
 #include "FormulaData.h"
+#include "Table.h"
+#include "Aggregate.h"
+#include "StringData.h"
+#include "FormulaParser.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 using namespace std;
 
+static const Expression EMPTY_EXPRESSION; /**< The expression of an empty formula, which evaluates to an error. */
+
 /**
- * @brief Default constructor for the FormulaData class.
- *
- * This constructor initializes the FormulaData object with default values.
- */
-FormulaData::FormulaData():FormulaData(0,0,"") {
-	this->type = FORMULA;
+* @struct FileText
+* @brief The text of a formula for file output, written into a caller-supplied buffer.
+* @details Text that does not fit is only counted, so the length of the whole formula is known.
+*/
+struct FileText {
+	char* buffer; /**< The buffer to write to. */
+	size_t size; /**< The size of the buffer. */
+	size_t length; /**< The length of the text so far, including what did not fit. */
+
+	/**
+	* @brief Appends characters, as many as still fit.
+	* @param text The characters.
+	* @param count The number of characters.
+	*/
+	void append(const char* text, const size_t count) {
+		if (this->length < this->size) {
+			std::memcpy(this->buffer + this->length, text, std::min(count, this->size - this->length));
+		}
+		this->length += count;
+	}
+};
+
+/**
+* @brief Appends a cell reference "R<row>C<col>".
+* @param text The text to append to.
+* @param row The row index of the cell.
+* @param col The column index of the cell.
+*/
+static void appendCell(FileText& text, const int row, const int col) {
+	char digits[16];
+	text.append("R", 1);
+	text.append(digits, std::to_chars(digits, digits + sizeof(digits), row).ptr - digits);
+	text.append("C", 1);
+	text.append(digits, std::to_chars(digits, digits + sizeof(digits), col).ptr - digits);
 }
 
 /**
- * @brief Constructor for the FormulaData class that initializes formula data with coordinates and operation.
- *
- * @param col1 The column index of the first cell.
- * @param row1 The row index of the first cell.
- * @param col2 The column index of the second cell.
- * @param row2 The row index of the second cell.
- * @param operation The operation to be performed on the cell values.
- */
-FormulaData::FormulaData(const int col1, const int row1, const int col2, const int row2, const std::string& operation) :col1(col1), row1(row1),
-col2(col2), row2(row2), operation(operation), dval1(0.0), dval2(0.0), courdinates(true), digits(false), dval3(0), mixed(false), whosFirst(false) {
-	this->type = FORMULA;
+* @brief Retrieves how strongly the subexpression ending at an instruction binds.
+* @param instruction The last instruction of the subexpression.
+* @return The precedence of the instruction, a negative number literal binds like a unary minus.
+*/
+static int subexpressionPrecedence(const Instruction& instruction) {
+	if (instruction.op == OP_PUSH_NUMBER && instruction.number < 0) {
+		return FormulaParser::UNARY;
+	}
+	return FormulaParser::precedence(instruction.op);
+}
+
+/**
+* @struct PrintFrame
+* @brief A subexpression being written by appendExpression().
+*/
+struct PrintFrame {
+	size_t end; /**< The index of the last instruction of the subexpression. */
+	unsigned step; /**< The number of operands written so far. */
+};
+
+/**
+* @brief Appends an operand, a number, a cell reference or an aggregate over a range.
+* @param text The text to append to.
+* @param instruction The instruction pushing the operand.
+* @param row The row index of the formula, the cell references are relative to it.
+* @param col The column index of the formula, the cell references are relative to it.
+*/
+static void appendOperand(FileText& text, const Instruction& instruction, const int row, const int col) {
+	if (instruction.op == OP_PUSH_NUMBER) {
+		char digits[Data::FORMAT_BUFFER_SIZE];
+		std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), instruction.number, std::chars_format::fixed, 6);
+		text.append(digits, result.ptr - digits);
+		return;
+	}
+	if (instruction.op == OP_PUSH_CELL) {
+		appendCell(text, row + instruction.row, col + instruction.col);
+		return;
+	}
+	const char* spelling = FormulaParser::spelling(instruction.op);
+	text.append(spelling, std::strlen(spelling));
+	text.append("(", 1);
+	appendCell(text, instruction.range.top, instruction.range.left);
+	text.append(":", 1);
+	appendCell(text, instruction.range.bottom, instruction.range.right);
+	text.append(")", 1);
+}
+
+/**
+* @brief Appends the subexpression ending at an instruction.
+* @details The subexpressions are written with an explicit stack instead of recursion, a long chain
+* like "R1C1 + R1C1 + ..." nests its left operands as deep as it is long. Every frame remembers
+* how many of its operands are written, the text around an operand is appended before it is
+* pushed and after it is popped.
+* @param text The text to append to.
+* @param code The instructions of the formula.
+* @param starts The index of the first instruction of the subexpression ending at every instruction.
+* @param frames Room for one frame per instruction.
+* @param end The index of the last instruction of the subexpression.
+* @param row The row index of the formula, the cell references are relative to it.
+* @param col The column index of the formula, the cell references are relative to it.
+*/
+static void appendExpression(FileText& text, const std::vector<Instruction>& code, const size_t* starts, PrintFrame* frames,
+	const size_t end, const int row, const int col) {
+	size_t depth = 0;
+	frames[depth++] = PrintFrame{ end, 0 };
+	while (depth > 0) {
+		PrintFrame& frame = frames[depth - 1];
+		const Instruction& instruction = code[frame.end];
+		int precedence = FormulaParser::precedence(instruction.op);
+		if (precedence == FormulaParser::OPERAND) {
+			appendOperand(text, instruction, row, col);
+			depth--;
+			continue;
+		}
+		if (instruction.op == OP_NEGATE) {
+			bool parenthesized = subexpressionPrecedence(code[frame.end - 1]) < precedence;
+			if (frame.step++ == 0) {
+				text.append("-(", parenthesized ? 2 : 1);
+				frames[depth++] = PrintFrame{ frame.end - 1, 0 };
+			}
+			else {
+				text.append(")", parenthesized ? 1 : 0);
+				depth--;
+			}
+			continue;
+		}
+		size_t right = frame.end - 1;
+		size_t left = starts[right] - 1;
+		bool leftParenthesized = subexpressionPrecedence(code[left]) < precedence;
+		bool rightParenthesized = subexpressionPrecedence(code[right]) <= precedence;
+		const char* spelling = FormulaParser::spelling(instruction.op);
+		switch (frame.step++) {
+		case 0:
+			text.append("(", leftParenthesized ? 1 : 0);
+			frames[depth++] = PrintFrame{ left, 0 };
+			break;
+		case 1:
+			text.append(")", leftParenthesized ? 1 : 0);
+			text.append(" ", 1);
+			text.append(spelling, std::strlen(spelling));
+			text.append(" ", 1);
+			text.append("(", rightParenthesized ? 1 : 0);
+			frames[depth++] = PrintFrame{ right, 0 };
+			break;
+		default:
+			text.append(")", rightParenthesized ? 1 : 0);
+			depth--;
+			break;
+		}
+	}
 }
 
 /**
- * @brief Constructor for the FormulaData class that initializes formula data with numerical values and operation.
+ * @brief Default constructor for the FormulaData class.
  *
- * @param dval1 The first numerical value.
- * @param dval2 The second numerical value.
- * @param operation The operation to be performed on the numerical values.
+ * This constructor initializes the FormulaData object with default values.
  */
-FormulaData::FormulaData(const double dval1, const double dval2, const std::string& operation):col1(0), row1(0),
-col2(0), row2(0), operation(operation), dval1(dval1), dval2(dval2), courdinates(false), digits(true), dval3(0), mixed(false), whosFirst(false) {
-	this->type = FORMULA;
+FormulaData::FormulaData():FormulaData(&EMPTY_EXPRESSION, 0, 0) {
 }
 
 /**
- * @brief Constructor for the FormulaData class that initializes formula data with a single numerical value, cell coordinates, and operation.
+ * @brief Constructor for the FormulaData class that evaluates a shared compiled expression.
  *
- * @param dval3 The numerical value used in the formula.
- * @param row The row coordinate of the cell.
- * @param col The column coordinate of the cell.
- * @param operation The operation to be performed on the cell value.
- * @param whosFirst A boolean value indicating whether the cell value comes first in the operation.
+ * @param expression The expression, interned in an ExpressionPool that outlives the formula.
+ * @param row The row index of the formula, the cell references of the expression are relative to it.
+ * @param col The column index of the formula, the cell references of the expression are relative to it.
  */
-FormulaData::FormulaData(const double dval3, const int row, const int col, std::string& operation, bool whosFirst) :col1(col), row1(row),
-col2(0), row2(0), operation(operation), dval1(dval3), dval2(0), courdinates(false), digits(false), mixed(true), dval3(dval3), whosFirst(whosFirst) {
+FormulaData::FormulaData(const Expression* expression, const int row, const int col) :expression(expression), row(row), col(col), evaluating(false), dirty(true) {
 	this->type = FORMULA;
 }
 
@@ -55,567 +184,421 @@ col2(0), row2(0), operation(operation), dval1(dval3), dval2(0), courdinates(fals
 * @return A string representation of the FormulaData object.
 */
 std::string FormulaData::stringify() const {
-	std::string tmp = "";
-	int integer1 = 0;
-	double floater1 = 0.0;
-	int integer2 = 0;
-	double floater2 = 0.0;
-	bool intFlag1 = false;
-	bool intFlag2 = false;
-	if (this->courdinates) {
-		if (this->row1 > Table::getInstance().getMaxRows() || this->col1 > Table::getInstance().getMaxCols()) {
-			integer1 = 0;
-			intFlag1 = true;
-		}
-		else if (Table::getInstance().getTable()[this->row1][this->col1]->getType() == FORMULA) {
-			std::string tmp = Table::getInstance().getTable()[this->row1][this->col1]->stringifyFile();
-			if (Confirmer::isFormula1(tmp)) {
-				std::vector<int> rows, cols;
-				std::string op;
-				Confirmer::extractData1(tmp, rows, op, cols);
-				if (this->row1 == rows[0] && this->col1 == cols[0]) {
-					integer1 = 0;
-					intFlag1 = true;
-				}
-				else if (this->row2 == rows[1] && this->col2 == cols[1]) {
-					integer1 = 0;
-					intFlag1 = true;
-				}
-				else {
-					std::string tmp2 = Table::getInstance().getTable()[this->row1][this->col1]->stringify();
-					if (Confirmer::isNum(tmp2)) {
-						integer1 = std::stoi(tmp2);
-						intFlag1 = true;
-					}
-					else if (Confirmer::isDouble(tmp2)) {
-						floater1 = std::stod(tmp2);
-					}
-					else {
-						integer1 = 0;
-						intFlag1 = true;
-					}
-				}
-			}
-			else if (Confirmer::isFormula2(tmp)) {
-				std::string tmp2 = Table::getInstance().getTable()[this->row1][this->col1]->stringify();
-				floater1 = std::stod(tmp2);
-			}
-			else if (Confirmer::isFormula3(tmp)) {
-				double dval3;
-				int row, col;
-				std::string op;
-				bool flag = Confirmer::extractData3(tmp, dval3, op, row, col);
-				if (this->row1 == row && this->col1 == col) {
-					integer1 = 0;
-					intFlag1 = true;
-				}
-				else if (this->row2 == row && this->col2 == col) {
-					integer1 = 0;
-					intFlag1 = true;
-				}
-				else {
-					std::string tmp2 = Table::getInstance().getTable()[this->row1][this->col1]->stringify();
-					if (Confirmer::isNum(tmp2)) {
-						integer1 = std::stoi(tmp2);
-						intFlag1 = true;
-					}
-					else if (Confirmer::isDouble(tmp2)) {
-						floater1 = std::stod(tmp2);
-					}
-					else {
-						integer1 = 0;
-						intFlag1 = true;
-					}
-				}
-			}
-		}
-		else if (Table::getInstance().getTable()[this->row1][this->col1]->getType() == STRING) {
-			tmp = Table::getInstance().getTable()[this->row1][this->col1]->stringify();
-			if (Confirmer::isDouble(tmp)) {
-				floater1 = std::stod(tmp);
-			}
-			else if (Confirmer::isNum(tmp)) {
-				integer1 = std::stoi(tmp);
-				intFlag1 = true;
-			}
-			else {
-				integer1 = 0;
-				intFlag1 = true;
-			}
-		}
-		else {
-			tmp = Table::getInstance().getTable()[this->row1][this->col1]->stringify();
-			if (Confirmer::isDouble(tmp)) {
-				floater1 = std::stod(tmp);
-			}
-			else if (Confirmer::isNum(tmp)) {
-				integer1 = std::stoi(tmp);
-				intFlag1 = true;
-			}
-		}
-		if (this->row2 > Table::getInstance().getMaxRows() || this->col2 > Table::getInstance().getMaxCols()) {
-			integer2 = 0;
-			intFlag2 = true;
-		}
-		else if (Table::getInstance().getTable()[this->row2][this->col2]->getType() == STRING) {
-			tmp = Table::getInstance().getTable()[this->row2][this->col2]->stringify();
-			if (Confirmer::isDouble(tmp)) {
-				floater2 = std::stod(tmp);
-			}
-			else if (Confirmer::isNum(tmp)) {
-				integer2 = std::stoi(tmp);
-				intFlag2 = true;
-			}
-			else {
-				integer2 = 0;
-				intFlag2 = true;
-			}
+	char text[FORMAT_BUFFER_SIZE];
+	size_t length = this->format(text, sizeof(text));
+	return std::string(text, std::min(length, sizeof(text)));
+}
+
+/**
+* @brief Evaluates the formula and writes its result into a caller-supplied buffer.
+* @param buffer The buffer to write to.
+* @param size The size of the buffer.
+* @return The length of the whole result.
+*/
+size_t FormulaData::format(char* buffer, const size_t size) const {
+	Value value = this->evaluate(Table::getInstance());
+	switch (value.type) {
+	case INT_VALUE:
+		return IntData(value.ival).format(buffer, size);
+	case DOUBLE_VALUE:
+		return DoubleData(value.dval).format(buffer, size);
+	case CYCLE_VALUE:
+		return copyText(buffer, size, "#CYCLE", 6);
+	default:
+		return copyText(buffer, size, "ERROR", 5);
+	}
+}
+
+/**
+* @brief Writes the formula for file output into a caller-supplied buffer.
+* @details The expression is rebuilt from the compiled instructions, with spaces around the binary
+* operators and parentheses only where the precedence of the operators needs them. The start of
+* every subexpression is found in one pass over the postfix instructions, then the expression is
+* written from its last instruction down, left operand first, with one frame per open
+* subexpression instead of recursion. Numbers and indices are written
+* with std::to_chars, nothing is allocated for expressions of up to MAX_LOCAL_CODE instructions.
+* @param buffer The buffer to write to.
+* @param size The size of the buffer.
+* @return The length of the whole formula.
+*/
+size_t FormulaData::formatFile(char* buffer, const size_t size) const {
+	const std::vector<Instruction>& code = this->expression->code;
+	FileText text = { buffer, size, 0 };
+	text.append("=", 1);
+	if (code.empty()) {
+		return text.length;
+	}
+	size_t local[MAX_LOCAL_CODE];
+	PrintFrame localFrames[MAX_LOCAL_CODE];
+	std::vector<size_t> heap;
+	std::vector<PrintFrame> heapFrames;
+	size_t* starts = local;
+	PrintFrame* frames = localFrames;
+	if (code.size() > MAX_LOCAL_CODE) {
+		heap.resize(code.size());
+		heapFrames.resize(code.size());
+		starts = heap.data();
+		frames = heapFrames.data();
+	}
+	for (size_t i = 0; i < code.size(); i++) {
+		if (code[i].op == OP_NEGATE) {
+			starts[i] = starts[i - 1];
 		}
-		else if (Table::getInstance().getTable()[this->row2][this->col2]->getType() == FORMULA) {
-			std::string tmp = Table::getInstance().getTable()[this->row2][this->col2]->stringifyFile();
-			if (Confirmer::isFormula1(tmp)) {
-				std::vector<int> rows, cols;
-				std::string op;
-				Confirmer::extractData1(tmp, rows, op, cols);
-				if (this->row1 == rows[0] && this->col1 == cols[0]) {
-					integer1 = 0;
-					intFlag1 = true;
-				}
-				else if (this->row2 == rows[1] && this->col2 == cols[1]) {
-					integer1 = 0;
-					intFlag1 = true;
-				}
-				else {
-					std::string tmp2 = Table::getInstance().getTable()[this->row2][this->col2]->stringify();
-					if (Confirmer::isNum(tmp2)) {
-						integer1 = std::stoi(tmp2);
-						intFlag1 = true;
-					}
-					else if (Confirmer::isDouble(tmp2)) {
-						floater1 = std::stod(tmp2);
-					}
-					else {
-						integer1 = 0;
-						intFlag1 = true;
-					}
-				}
-			}
-			else if (Confirmer::isFormula2(tmp)) {
-				std::string tmp2 = Table::getInstance().getTable()[this->row2][this->col2]->stringify();
-				floater1 = std::stod(tmp2);
-			}
-			else if (Confirmer::isFormula3(tmp)) {
-				double dval3;
-				int row, col;
-				std::string op;
-				bool flag = Confirmer::extractData3(tmp, dval3, op, row, col);
-				if (this->row1 == row && this->col1 == col) {
-					integer1 = 0;
-					intFlag1 = true;
-				}
-				else if (this->row2 == row && this->col2 == col) {
-					integer1 = 0;
-					intFlag1 = true;
-				}
-				else {
-					std::string tmp2 = Table::getInstance().getTable()[this->row2][this->col2]->stringify();
-					if (Confirmer::isNum(tmp2)) {
-						integer1 = std::stoi(tmp2);
-						intFlag1 = true;
-					}
-					else if (Confirmer::isDouble(tmp2)) {
-						floater1 = std::stod(tmp2);
-					}
-					else {
-						integer1 = 0;
-						intFlag1 = true;
-					}
-				}
-			}
+		else if (FormulaParser::precedence(code[i].op) == FormulaParser::OPERAND) {
+			starts[i] = i;
 		}
 		else {
-			tmp = Table::getInstance().getTable()[this->row2][this->col2]->stringify();
-			if (Confirmer::isDouble(tmp)) {
-				floater2 = std::stod(tmp);
-			}
-			else if (Confirmer::isNum(tmp)) {
-				integer2 = std::stoi(tmp);
-				intFlag2 = true;
-			}
+			starts[i] = starts[starts[i - 1] - 1];
 		}
 	}
-	else if (this->mixed) {
-		if (this->whosFirst) {
-			if (this->row1 > Table::getInstance().getMaxRows() || this->col1 > Table::getInstance().getMaxCols()) {
-				integer1 = 0;
-				intFlag1 = true;
-			}
-			else if (Table::getInstance().getTable()[this->row1][this->col1]->getType() == FORMULA) {
-
-				std::string tmp = Table::getInstance().getTable()[this->row1][this->col1]->stringifyFile();
-				if (Confirmer::isFormula1(tmp)) {
-					std::vector<int> rows, cols;
-					std::string op;
-					Confirmer::extractData1(tmp, rows, op, cols);
-					if (this->row1 == rows[0] && this->col1 == cols[0]) {
-						integer1 = 0;
-						intFlag1 = true;
-					}
-					else {
-						std::string tmp2 = Table::getInstance().getTable()[this->row1][this->col1]->stringify();
-						if (Confirmer::isNum(tmp2)) {
-							integer1 = std::stoi(tmp2);
-							intFlag1 = true;
-						}
-						else if (Confirmer::isDouble(tmp2)) {
-							floater1 = std::stod(tmp2);
-						}
-						else {
-							integer1 = 0;
-							intFlag1 = true;
-						}
-					}
-				}
-				else if (Confirmer::isFormula2(tmp)) {
-					std::string tmp2 = Table::getInstance().getTable()[this->row1][this->col1]->stringify();
-					floater1 = std::stod(tmp2);
-				}
-				else if (Confirmer::isFormula3(tmp)) {
-					double dval3;
-					int row, col;
-					std::string op;
-					bool flag = Confirmer::extractData3(tmp, dval3, op, row, col);
-					if (this->row1 == row && this->col1 == col) {
-						integer1 = 0;
-						intFlag1 = true;
-					}
-					else {
-						std::string tmp2 = Table::getInstance().getTable()[this->row1][this->col1]->stringify();
-						if (Confirmer::isNum(tmp2)) {
-							integer1 = std::stoi(tmp2);
-							intFlag1 = true;
-						}
-						else if (Confirmer::isDouble(tmp2)) {
-							floater1 = std::stod(tmp2);
-						}
-						else {
-							integer1 = 0;
-							intFlag1 = true;
-						}
-					}
-				}
-			}
-			else if (Table::getInstance().getTable()[this->row1][this->col1]->getType() == STRING) {
-				tmp = Table::getInstance().getTable()[this->row1][this->col1]->stringify();
-				if (Confirmer::isDouble(tmp)) {
-					floater1 = std::stod(tmp);
-				}
-				else if (Confirmer::isNum(tmp)) {
-					integer1 = std::stoi(tmp);
-					intFlag1 = true;
-				}
-				else {
-					integer1 = 0;
-					intFlag1 = true;
-				}
-			}
-			else {
-				tmp = Table::getInstance().getTable()[this->row1][this->col1]->stringify();
-				if (Confirmer::isDouble(tmp)) {
-					floater1 = std::stod(tmp);
-				}
-				else if (Confirmer::isNum(tmp)) {
-					integer1 = std::stoi(tmp);
-					intFlag1 = true;
-				}
-			}
-			floater2 = this->dval3;
+	appendExpression(text, code, starts, frames, code.size() - 1, this->row, this->col);
+	return text.length;
+}
+
+/**
+* @brief Reads the value of a cell referenced by a formula.
+*
+* Numbers are taken from the cell as they are stored, strings and formulas are evaluated through
+* the Data interface, so no text is formatted and parsed again on the way. Numbers and numeric
+* strings are read as doubles, only the results of referenced formulas keep their integer type.
+* Empty cells, other strings, failed formulas, formulas of a cycle and cells outside of the table
+* count as the integer 0.
+*
+* @param table The table to read from.
+* @param row The row index of the cell.
+* @param col The column index of the cell.
+* @return The value of the cell.
+*/
+static Value cellValue(const Table& table, const int row, const int col) {
+	Value value;
+	Cell cell = table.getCell(row, col);
+	switch (cell.type) {
+	case INT:
+		value.type = DOUBLE_VALUE;
+		value.dval = cell.ival;
+		return value;
+	case DOUBLE:
+		value.type = DOUBLE_VALUE;
+		value.dval = cell.dval;
+		return value;
+	case STRING:
+		value = StringData(std::string_view(cell.sval, cell.size)).evaluate(table);
+		if (value.type == INT_VALUE) {
+			value.type = DOUBLE_VALUE;
+			value.dval = value.ival;
+		}
+		break;
+	default:
+		value = cell.fval->evaluate(table);
+		break;
+	}
+	if (value.type == ERROR_VALUE || value.type == CYCLE_VALUE) {
+		value = Value();
+	}
+	return value;
+}
+
+/**
+* @brief Applies an aggregate function to the numbers of a range.
+* @param table The table to read from.
+* @param instruction The aggregate instruction holding the function and the range.
+* @return The result, COUNT gives an integer and the other functions a double. The average of a
+* range without numbers is an ERROR_VALUE, its minimum and maximum are 0.
+*/
+static Value aggregateValue(const Table& table, const Instruction& instruction) {
+	Value value;
+	Aggregate total;
+	table.aggregate(instruction.range, total);
+	if (instruction.op == OP_COUNT) {
+		value.ival = static_cast<int>(total.count);
+		return value;
+	}
+	value.type = DOUBLE_VALUE;
+	switch (instruction.op) {
+	case OP_SUM:
+		value.dval = total.sum;
+		break;
+	case OP_AVERAGE:
+		if (total.count == 0) {
+			value.type = ERROR_VALUE;
 		}
 		else {
-			floater1 = this->dval1;
-			if (this->row1 > Table::getInstance().getMaxRows() || this->col1 > Table::getInstance().getMaxCols()) {
-				integer2 = 0;
-				intFlag2 = true;
-			}
-			else if (Table::getInstance().getTable()[this->row1][this->col1]->getType() == FORMULA) {
-				std::string tmp = Table::getInstance().getTable()[this->row1][this->col1]->stringifyFile();
-				if (Confirmer::isFormula1(tmp)) {
-					std::vector<int> rows, cols;
-					std::string op;
-					Confirmer::extractData1(tmp, rows, op, cols);
-					if (this->row1 == rows[0] && this->col1 == cols[0]) {
-						integer1 = 0;
-						intFlag1 = true;
-					}
-					else {
-						std::string tmp2 = Table::getInstance().getTable()[this->row1][this->col1]->stringify();
-						if (Confirmer::isNum(tmp2)) {
-							integer1 = std::stoi(tmp2);
-							intFlag1 = true;
-						}
-						else if (Confirmer::isDouble(tmp2)) {
-							floater1 = std::stod(tmp2);
-						}
-						else {
-							integer1 = 0;
-							intFlag1 = true;
-						}
-					}
-				}
-				else if (Confirmer::isFormula2(tmp)) {
-					std::string tmp2 = Table::getInstance().getTable()[this->row1][this->col1]->stringify();
-					floater1 = std::stod(tmp2);
-				}
-				else if (Confirmer::isFormula3(tmp)) {
-					double dval3;
-					int row, col;
-					std::string op;
-					bool flag = Confirmer::extractData3(tmp, dval3, op, row, col);
-					if (this->row1 == row && this->col1 == col) {
-						integer1 = 0;
-						intFlag1 = true;
-					}
-					else {
-						std::string tmp2 = Table::getInstance().getTable()[this->row1][this->col1]->stringify();
-						if (Confirmer::isNum(tmp2)) {
-							integer1 = std::stoi(tmp2);
-							intFlag1 = true;
-						}
-						else if (Confirmer::isDouble(tmp2)) {
-							floater1 = std::stod(tmp2);
-						}
-						else {
-							integer1 = 0;
-							intFlag1 = true;
-						}
-					}
-				}
+			value.dval = total.sum / total.count;
+		}
+		break;
+	case OP_MIN:
+		value.dval = total.count == 0 ? 0 : total.min;
+		break;
+	default:
+		value.dval = total.count == 0 ? 0 : total.max;
+		break;
+	}
+	return value;
+}
+
+/**
+* @brief Applies a binary operation to two values.
+* @details Two integers give an integer, anything else is computed in double. Comparisons give 1 or 0.
+* @param op The operation.
+* @param left The first operand.
+* @param right The second operand.
+* @return The result, an ERROR_VALUE for a division by zero or an erroneous operand.
+*/
+static Value apply(const OpCode op, const Value& left, const Value& right) {
+	Value result;
+	if (left.type == ERROR_VALUE || right.type == ERROR_VALUE) {
+		result.type = ERROR_VALUE;
+		return result;
+	}
+	if (left.type == INT_VALUE && right.type == INT_VALUE) {
+		unsigned a = left.ival;
+		unsigned b = right.ival;
+		switch (op) {
+		case OP_ADD:
+			result.ival = static_cast<int>(a + b);
+			return result;
+		case OP_SUBTRACT:
+			result.ival = static_cast<int>(a - b);
+			return result;
+		case OP_MULTIPLY:
+			result.ival = static_cast<int>(a * b);
+			return result;
+		case OP_DIVIDE:
+			if (right.ival == 0) {
+				result.type = ERROR_VALUE;
 			}
-			else if (Table::getInstance().getTable()[this->row1][this->col1]->getType() == STRING) {
-				tmp = Table::getInstance().getTable()[this->row1][this->col1]->stringify();
-				if (Confirmer::isDouble(tmp)) {
-					floater2 = std::stod(tmp);
-				}
-				else if (Confirmer::isNum(tmp)) {
-					integer2 = std::stoi(tmp);
-					intFlag2 = true;
-				}
-				else {
-					integer2 = 0;
-					intFlag2 = true;
-				}
+			else if (right.ival == -1) {
+				result.ival = static_cast<int>(0u - a);
 			}
 			else {
-				tmp = Table::getInstance().getTable()[this->row1][this->col1]->stringify();
-				if (Confirmer::isDouble(tmp)) {
-					floater2 = std::stod(tmp);
-				}
-				else if (Confirmer::isNum(tmp)) {
-					integer2 = std::stoi(tmp);
-					intFlag2 = true;
-				}
+				result.ival = left.ival / right.ival;
 			}
+			return result;
+		default:
+			break;
 		}
 	}
-	std::string result = "";
-	if ((this->courdinates || this->mixed) && intFlag1 && intFlag2) {
-		if (this->operation == "+") {
-			result += to_string(integer1 + integer2);
-		}
-		else if (this->operation == "-") {
-			result += to_string(integer1 - integer2);
-		}
-		else if (this->operation == "*") {
-			result += to_string(integer1 * integer2);
-		}
-		else if (this->operation == "/") {
-			if (integer2 == 0) {
-				result += "ERROR";
-			}
-			else result += to_string(integer1 / integer2);
-		}
-		else if (this->operation == "<") {
-			result += to_string(integer1 < integer2);
-		}
-		else if (this->operation == ">") {
-			result += to_string(integer1 > integer2);
-		}
-		else if (this->operation == "<=") {
-			result += to_string(integer1 <= integer2);
-		}
-		else if (this->operation == ">=") {
-			result += to_string(integer1 >= integer2);
-		}
-		else if (this->operation == "==") {
-			result += to_string(integer1 == integer2);
-		}
-		else if (this->operation == "!=") {
-			result += to_string(integer1 != integer2);
-		}
+	double a = left.type == INT_VALUE ? left.ival : left.dval;
+	double b = right.type == INT_VALUE ? right.ival : right.dval;
+	result.type = DOUBLE_VALUE;
+	switch (op) {
+	case OP_ADD:
+		result.dval = a + b;
+		break;
+	case OP_SUBTRACT:
+		result.dval = a - b;
+		break;
+	case OP_MULTIPLY:
+		result.dval = a * b;
+		break;
+	case OP_DIVIDE:
+		if (b == 0) {
+			result.type = ERROR_VALUE;
+		}
+		result.dval = a / b;
+		break;
+	default:
+		result.type = INT_VALUE;
+		result.ival = (op == OP_LESS && a < b) || (op == OP_GREATER && a > b) || (op == OP_LESS_EQUAL && a <= b)
+			|| (op == OP_GREATER_EQUAL && a >= b) || (op == OP_EQUAL && a == b) || (op == OP_NOT_EQUAL && a != b);
+		break;
 	}
-	else if ((this->courdinates || this->mixed) && intFlag1 && !intFlag2) {
-		if (this->operation == "+") {
-			result += to_string(integer1 + floater2);
-		}
-		else if (this->operation == "-") {
-			result += to_string(integer1 - floater2);
-		}
-		else if (this->operation == "*") {
-			result += to_string(integer1 * floater2);
-		}
-		else if (this->operation == "/") {
-			if (floater2 == 0) {
-				result += "ERROR";
-			}
-			else result += to_string(integer1 / floater2);
-		}
-		else if (this->operation == "<") {
-			result += to_string(integer1 < floater2);
-		}
-		else if (this->operation == ">") {
-			result += to_string(integer1 > floater2);
-		}
-		else if (this->operation == "<=") {
-			result += to_string(integer1 <= floater2);
-		}
-		else if (this->operation == ">=") {
-			result += to_string(integer1 >= floater2);
-		}
-		else if (this->operation == "==") {
-			result += to_string(integer1 == floater2);
-		}
-		else if (this->operation == "!=") {
-			result += to_string(integer1 != floater2);
-		}
+	return result;
+}
+
+/**
+* @brief Negates a value.
+* @details Integers wrap around like the arithmetic operations, errors stay errors.
+* @param value The operand.
+* @return The negated value.
+*/
+static Value negateValue(const Value& value) {
+	Value result = value;
+	if (value.type == INT_VALUE) {
+		result.ival = static_cast<int>(0u - static_cast<unsigned>(value.ival));
 	}
-	else if ((this->courdinates || this->mixed) && !intFlag1 && intFlag2) {
-		if (this->operation == "+") {
-			result += to_string(floater1 + integer2);
-		}
-		else if (this->operation == "-") {
-			result += to_string(floater1 - integer2);
-		}
-		else if (this->operation == "*") {
-			result += to_string(floater1 * integer2);
-		}
-		else if (this->operation == "/") {
-			if (integer2 == 0) {
-				result += "ERROR";
-			}
-			else result += to_string(floater1 / integer2);
-		}
-		else if (this->operation == "<") {
-			result += to_string(floater1 < integer2);
-		}
-		else if (this->operation == ">") {
-			result += to_string(floater1 > integer2);
-		}
-		else if (this->operation == "<=") {
-			result += to_string(floater1 <= integer2);
-		}
-		else if (this->operation == ">=") {
-			result += to_string(floater1 >= integer2);
-		}
-		else if (this->operation == "==") {
-			result += to_string(floater1 == integer2);
-		}
-		else if (this->operation == "!=") {
-			result += to_string(floater1 != integer2);
-		}
+	else if (value.type == DOUBLE_VALUE) {
+		result.dval = -value.dval;
 	}
-	else if ((this->courdinates || this->mixed) && !intFlag1 && !intFlag2) {
-		if (this->operation == "+") {
-			result += to_string(floater1 + floater2);
-		}
-		else if (this->operation == "-") {
-			result += to_string(floater1 - floater2);
-		}
-		else if (this->operation == "*") {
-			result += to_string(floater1 * floater2);
-		}
-		else if (this->operation == "/") {
-			if (floater2 == 0) {
-				result += "ERROR";
-			}
-			result += to_string(floater1 / floater2);
-		}
-		else if (this->operation == "<") {
-			result += to_string(floater1 < floater2);
-		}
-		else if (this->operation == ">") {
-			result += to_string(floater1 > floater2);
-		}
-		else if (this->operation == "<=") {
-			result += to_string(floater1 <= floater2);
-		}
-		else if (this->operation == ">=") {
-			result += to_string(floater1 >= floater2);
-		}
-		else if (this->operation == "==") {
-			result += to_string(floater1 == floater2);
-		}
-		else if (this->operation == "!=") {
-			result += to_string(floater1 != floater2);
-		}
+	return result;
+}
+
+/**
+* @brief Evaluates the compiled formula on a value stack.
+* @details The result is cached until the formula is invalidated. Referenced formulas are evaluated
+* recursively, a reference back to a formula that is still being evaluated gives an ERROR_VALUE
+* instead of recursing forever.
+* @param table The table the referenced cells are read from.
+* @return The typed result of the formula.
+*/
+Value FormulaData::evaluate(const Table& table) const {
+	Value local[MAX_STACK];
+	std::vector<Value> heap;
+	Value* stack = local;
+	size_t top = 0;
+	const std::vector<Instruction>& code = this->expression->folded.empty() ? this->expression->code : this->expression->folded;
+	if (!this->dirty) {
+		return this->cached;
 	}
-	else {
-		if (this->operation == "+") {
-			result += std::to_string(this->dval1 + this->dval2);
-		}
-		else if (this->operation == "-") {
-			result += to_string(this->dval1 - this->dval2);
-		}
-		else if (this->operation == "*") {
-			result += to_string(this->dval1 * this->dval2);
-		}
-		else if (this->operation == "/") {
-			if (this->dval2 == 0) {
-				result += "ERROR";
-			}
-			result += to_string(this->dval1 / this->dval2);
-		}
-		else if (this->operation == "<") {
-			result += to_string(this->dval1 < this->dval2);
-		}
-		else if (this->operation == ">") {
-			result += to_string(this->dval1 > this->dval2);
-		}
-		else if (this->operation == "<=") {
-			result += to_string(this->dval1 <= this->dval2);
-		}
-		else if (this->operation == ">=") {
-			result += to_string(this->dval1 >= this->dval2);
+	if (this->evaluating || code.empty()) {
+		local[0].type = ERROR_VALUE;
+		return local[0];
+	}
+	if (this->expression->stackDepth > MAX_STACK) {
+		heap.resize(this->expression->stackDepth);
+		stack = heap.data();
+	}
+	this->evaluating = true;
+	for (const Instruction& instruction : code) {
+		switch (instruction.op) {
+		case OP_PUSH_NUMBER:
+			stack[top].type = DOUBLE_VALUE;
+			stack[top].dval = instruction.number;
+			top++;
+			break;
+		case OP_PUSH_CELL:
+			stack[top++] = cellValue(table, this->row + instruction.row, this->col + instruction.col);
+			break;
+		case OP_SUM:
+		case OP_AVERAGE:
+		case OP_MIN:
+		case OP_MAX:
+		case OP_COUNT:
+			stack[top++] = aggregateValue(table, instruction);
+			break;
+		case OP_NEGATE:
+			stack[top - 1] = negateValue(stack[top - 1]);
+			break;
+		default:
+			top--;
+			stack[top - 1] = apply(instruction.op, stack[top - 1], stack[top]);
+			break;
 		}
-		else if (this->operation == "==") {
-			result += to_string(this->dval1 == this->dval2);
+	}
+	this->evaluating = false;
+	this->cached = stack[0];
+	this->dirty = false;
+	return this->cached;
+}
+
+/**
+* @brief Retrieves the cells the formula reads.
+* @return The row and column indices of the cell operands.
+*/
+std::vector<std::pair<int, int>> FormulaData::getReferences() const {
+	std::vector<std::pair<int, int>> references;
+	for (const Instruction& instruction : this->expression->code) {
+		if (instruction.op == OP_PUSH_CELL) {
+			references.push_back(std::make_pair(this->row + instruction.row, this->col + instruction.col));
 		}
-		else if (this->operation == "!=") {
-			result += to_string(this->dval1 != this->dval2);
+	}
+	return references;
+}
+
+/**
+* @brief Retrieves the ranges the formula reads.
+* @return The ranges of the aggregate functions.
+*/
+std::vector<CellRange> FormulaData::getRanges() const {
+	std::vector<CellRange> ranges;
+	for (const Instruction& instruction : this->expression->code) {
+		if (instruction.op >= OP_SUM) {
+			ranges.push_back(instruction.range);
 		}
 	}
-	return result;
+	return ranges;
+}
+
+/**
+* @brief Retrieves the compiled expression of the formula.
+* @return The expression, shared with every formula written the same way.
+*/
+const Expression* FormulaData::getExpression() const {
+	return this->expression;
+}
+
+/**
+* @brief Moves the formula down, keeping the cells it reads.
+* @details Used when the rows of a store are appended to another one, the cells the formula reads
+* move with it only if the expression is rebased.
+* @param expression The expression with the cell references rebased by makeRelative() with the same number of rows.
+* @param rows The number of rows to move the formula by.
+*/
+void FormulaData::moveDown(const Expression* expression, const int rows) {
+	this->expression = expression;
+	this->row += rows;
+}
+
+/**
+* @brief Checks whether other formulas share the expression and compute the same result.
+* @details An expression reading single cells reads different cells for every formula sharing it.
+* @return `true` if the expression is shared and reads no single cells, `false` otherwise.
+*/
+bool FormulaData::isShared() const {
+	return this->expression->references > 1 && !this->expression->relative;
+}
+
+/**
+* @brief Takes over the result of a formula with the same expression instead of evaluating again.
+* @details Expressions without single cells only read ranges by their absolute coordinates, so
+* formulas sharing one have the same result once the cells they read are evaluated.
+* @param other The evaluated formula.
+*/
+void FormulaData::adopt(const FormulaData& other) {
+	this->cached = other.cached;
+	this->dirty = other.dirty;
+}
+
+/**
+* @brief Drops the cached result, so the next evaluation recomputes it.
+*/
+void FormulaData::invalidate() {
+	this->dirty = true;
+}
+
+/**
+* @brief Sets the result of a formula that reads itself, directly or through other formulas, to #CYCLE.
+* @details The result stays cached until an edit invalidates the formula.
+*/
+void FormulaData::markCycle() {
+	this->cached = Value();
+	this->cached.type = CYCLE_VALUE;
+	this->dirty = false;
+}
+
+/**
+* @brief Retrieves the cached result without evaluating the formula.
+* @return The result of the last evaluation, meaningless while the formula is dirty.
+*/
+Value FormulaData::getResult() const {
+	return this->cached;
+}
+
+/**
+* @brief Sets a result saved with the formula, so it is not evaluated again.
+* @details Used when a table is loaded from a snapshot, which holds the results of all formulas.
+* The result stays cached until an edit invalidates the formula.
+* @param result The result.
+*/
+void FormulaData::restore(const Value& result) {
+	this->cached = result;
+	this->dirty = false;
 }
 
 /**
 * @brief Converts the FormulaData object to a string representation for file output.
+* @details The text is written by formatFile(), into a local buffer if it fits.
 * @return A string representation of the FormulaData object for file output.
 */
 std::string FormulaData::stringifyFile() const {
-	std::string tmp = "";
-	tmp += '=';
-	if (this->courdinates) {
-		tmp += "R" + std::to_string(this->row1) + "C" + std::to_string(this->col1) + " " + this->operation + " " + "R" + std::to_string(this->row2) + "C" + std::to_string(this->col2);
-	}
-	else if (this->mixed && this->whosFirst) {
-		tmp += "R" + std::to_string(this->row1) + "C" + std::to_string(this->col1) + " " + this->operation + " " + std::to_string(this->dval3);
-	}
-	else if (this->mixed && !this->whosFirst) {
-		tmp += std::to_string(this->dval3) + " " + this->operation + " " + "R" + std::to_string(this->row1) + "C" + std::to_string(this->col1);
+	char text[FORMAT_BUFFER_SIZE];
+	size_t length = this->formatFile(text, sizeof(text));
+	if (length <= sizeof(text)) {
+		return std::string(text, length);
 	}
-	else {
-		tmp += std::to_string(this->dval1) + " " + this->operation + " " + std::to_string(this->dval2);
-	}
-	return tmp;
+	std::string file(length, '\0');
+	this->formatFile(&file[0], length);
+	return file;
 }
 
 /**
@@ -624,4 +607,99 @@ std::string FormulaData::stringifyFile() const {
 */
 DataType FormulaData::getType() const {
 	return this->type;
-}
\ No newline at end of file
+}
+
+/**
+* @brief Turns the cell references of instructions into offsets from the cell of their formula.
+* @details Formulas copied down a column then compile to equal instructions. Ranges keep their
+* absolute coordinates, so the formulas totalling the same range keep sharing their result.
+* Applied to instructions that are already relative, it rebases them for a formula moved by row and col.
+* @param code The instructions produced by FormulaParser.
+* @param row The row index of the formula.
+* @param col The column index of the formula.
+*/
+void FormulaData::makeRelative(std::vector<Instruction>& code, const int row, const int col) {
+	for (Instruction& instruction : code) {
+		if (instruction.op == OP_PUSH_CELL) {
+			instruction.row -= row;
+			instruction.col -= col;
+		}
+	}
+}
+
+/**
+* @brief Folds the operations whose operands are all number literals into a single literal.
+* @details The literals are folded with the same arithmetic the evaluation uses, most formulas have
+* nothing to fold and are only scanned once. Operations that
+* give an integer, like the comparisons, or an error, like a division by zero, are kept, since a
+* literal always evaluates to a double. Only the evaluated instructions are folded, the formula is
+* still saved the way it was written.
+* @param code The instructions produced by FormulaParser.
+* @return The folded instructions, empty if nothing could be folded.
+*/
+std::vector<Instruction> FormulaData::fold(const std::vector<Instruction>& code) {
+	std::vector<Instruction> folded;
+	bool changed = false;
+	bool foldable = false;
+	for (size_t i = 0; i + 1 < code.size() && !foldable; i++) {
+		foldable = code[i].op == OP_PUSH_NUMBER && (code[i + 1].op == OP_NEGATE || (code[i + 1].op == OP_PUSH_NUMBER
+			&& i + 2 < code.size() && FormulaParser::precedence(code[i + 2].op) < FormulaParser::UNARY));
+	}
+	if (!foldable) {
+		return folded;
+	}
+	folded.reserve(code.size());
+	for (const Instruction& instruction : code) {
+		folded.push_back(instruction);
+		size_t size = folded.size();
+		Value left;
+		Value right;
+		left.type = DOUBLE_VALUE;
+		right.type = DOUBLE_VALUE;
+		if (instruction.op == OP_NEGATE && size >= 2 && folded[size - 2].op == OP_PUSH_NUMBER) {
+			left.dval = folded[size - 2].number;
+			folded.pop_back();
+			folded.back().number = negateValue(left).dval;
+			changed = true;
+			continue;
+		}
+		if (FormulaParser::precedence(instruction.op) >= FormulaParser::UNARY || size < 3
+			|| folded[size - 3].op != OP_PUSH_NUMBER || folded[size - 2].op != OP_PUSH_NUMBER) {
+			continue;
+		}
+		left.dval = folded[size - 3].number;
+		right.dval = folded[size - 2].number;
+		Value result = apply(instruction.op, left, right);
+		if (result.type == DOUBLE_VALUE) {
+			folded.resize(size - 2);
+			folded.back().number = result.dval;
+			changed = true;
+		}
+	}
+	if (!changed) {
+		return std::vector<Instruction>();
+	}
+	folded.shrink_to_fit();
+	return folded;
+}
+
+/**
+* @brief Computes the deepest value stack a sequence of instructions needs.
+* @details Operands push a value, unary minus replaces one and the binary operations replace two by one.
+* @param code The instructions.
+* @return The number of values on the stack at its fullest.
+*/
+size_t FormulaData::stackDepth(const std::vector<Instruction>& code) {
+	size_t depth = 0;
+	size_t deepest = 0;
+	for (const Instruction& instruction : code) {
+		if (FormulaParser::precedence(instruction.op) == FormulaParser::OPERAND) {
+			depth++;
+		}
+		else if (instruction.op != OP_NEGATE) {
+			depth--;
+		}
+		deepest = std::max(deepest, depth);
+	}
+	return deepest;
+}
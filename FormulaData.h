@@ -1,6 +1,11 @@
 #pragma once
 #include "Data.h"
-#include "Table.h"
+#include <vector>
+#include <utility>
+#include "Expression.h"
+#include "Value.h"
+
+class Table;
 
 /**
  * @class FormulaData
@@ -14,35 +19,12 @@ public:
 	FormulaData();
 
 	/**
-	 * @brief Constructs a FormulaData object with two row/column coordinates and an operation string.
-	 * @param row1 The row coordinate of the first operand.
-	 * @param col1 The column coordinate of the first operand.
-	 * @param row2 The row coordinate of the second operand.
-	 * @param col2 The column coordinate of the second operand.
-	 * @param operation The operation string.
-	 */
-	FormulaData(const int row1, const int col1, const int row2, const int col2, const std::string& operation);
-
-	/**
-	 * @brief Constructs a FormulaData object with two double values and an operation string.
-	 * @param dval1 The first double value.
-	 * @param dval2 The second double value.
-	 * @param operation The operation string.
-	 */
-	FormulaData(const double dval1, const double dval2, const std::string& operation);
-
-	/**
-	 * @brief Constructs a FormulaData object with a double value, row/column coordinates, an operation string, and flags.
-	 * @param dval1 The double value.
-	 * @param row1 The row coordinate.
-	 * @param col1 The column coordinate.
-	 * @param operation The operation string.
-	 * @param digits Flag indicating if the formula contains digit placeholders.
-	 * @param courdinates Flag indicating if the formula contains row/column placeholders.
-	 * @param mixed Flag indicating if the formula contains a mix of digits and placeholders.
-	 * @param whosFirst Flag indicating if the formula starts with row/column placeholders.
+	 * @brief Constructs a FormulaData object evaluating a shared compiled expression.
+	 * @param expression The expression, interned in an ExpressionPool.
+	 * @param row The row index of the formula, the cell references of the expression are relative to it.
+	 * @param col The column index of the formula, the cell references of the expression are relative to it.
 	 */
-	FormulaData(const double dval1, const int row1, const int col1, std::string& operation, bool whosFirst);
+	FormulaData(const Expression* expression, const int row, const int col);
 
 	/**
 	 * @brief Converts the FormulaData object to a string representation.
@@ -56,28 +38,129 @@ public:
 	 */
 	virtual std::string stringifyFile() const override;
 
+	/**
+	 * @brief Writes the string representation of the FormulaData object into a caller-supplied buffer.
+	 * @param buffer The buffer to write to.
+	 * @param size The size of the buffer.
+	 * @return The length of the whole string representation.
+	 */
+	virtual size_t format(char* buffer, const size_t size) const override;
+
+	/**
+	 * @brief Writes the string representation of the FormulaData object for file output into a caller-supplied buffer.
+	 * @param buffer The buffer to write to.
+	 * @param size The size of the buffer.
+	 * @return The length of the whole string representation for file output.
+	 */
+	virtual size_t formatFile(char* buffer, const size_t size) const override;
+
 	/**
 	 * @brief Retrieves the data type of the FormulaData object.
 	 * @return The data type of the FormulaData object (DataType::FORMULA).
 	 */
 	virtual DataType getType() const override;
 
+	/**
+	 * @brief Evaluates the compiled formula, or returns the cached result if nothing it reads has changed.
+	 * @param table The table the referenced cells are read from.
+	 * @return The typed result, an ERROR_VALUE if the formula refers back to itself while it is evaluated.
+	 */
+	virtual Value evaluate(const Table& table) const override;
+
+	/**
+	 * @brief Retrieves the cells the formula reads.
+	 * @return The row and column indices of the cell operands.
+	 */
+	std::vector<std::pair<int, int>> getReferences() const;
+
+	/**
+	 * @brief Retrieves the ranges the formula reads.
+	 * @return The ranges of the aggregate functions.
+	 */
+	std::vector<CellRange> getRanges() const;
+
+	/**
+	 * @brief Retrieves the compiled expression of the formula.
+	 * @return The expression, shared with every formula written the same way.
+	 */
+	const Expression* getExpression() const;
+
+	/**
+	 * @brief Moves the formula down, keeping the cells it reads.
+	 * @param expression The expression with the cell references rebased by makeRelative() with the same number of rows.
+	 * @param rows The number of rows to move the formula by.
+	 */
+	void moveDown(const Expression* expression, const int rows);
+
+	/**
+	 * @brief Checks whether other formulas share the expression and compute the same result.
+	 * @return `true` if the expression is shared and reads no single cells, `false` otherwise.
+	 */
+	bool isShared() const;
+
+	/**
+	 * @brief Takes over the result of a formula with the same expression instead of evaluating again.
+	 * @param other The evaluated formula.
+	 */
+	void adopt(const FormulaData& other);
+
+	/**
+	 * @brief Drops the cached result, so the next evaluation recomputes it.
+	 */
+	void invalidate();
+
+	/**
+	 * @brief Sets the result of a formula that reads itself, directly or through other formulas, to #CYCLE.
+	 */
+	void markCycle();
+
+	/**
+	 * @brief Retrieves the cached result without evaluating the formula.
+	 * @return The result of the last evaluation, meaningless while the formula is dirty.
+	 */
+	Value getResult() const;
+
+	/**
+	 * @brief Sets a result saved with the formula, so it is not evaluated again.
+	 * @param result The result.
+	 */
+	void restore(const Value& result);
+
 	/**
 	 * @brief Destructs the FormulaData object.
 	 */
 	~FormulaData() override {}
 
+	/**
+	 * @brief Turns the cell references of instructions into offsets from the cell of their formula.
+	 * @param code The instructions produced by FormulaParser.
+	 * @param row The row index of the formula.
+	 * @param col The column index of the formula.
+	 */
+	static void makeRelative(std::vector<Instruction>& code, const int row, const int col);
+
+	/**
+	 * @brief Folds the operations whose operands are all number literals into a single literal.
+	 * @param code The instructions produced by FormulaParser.
+	 * @return The folded instructions, empty if nothing could be folded.
+	 */
+	static std::vector<Instruction> fold(const std::vector<Instruction>& code);
+
+	/**
+	 * @brief Computes the deepest value stack a sequence of instructions needs.
+	 * @param code The instructions.
+	 * @return The number of values on the stack at its fullest.
+	 */
+	static size_t stackDepth(const std::vector<Instruction>& code);
+
 private:
-	double dval1; /**< The first double value of the formula. */
-	double dval2; /**< The second double value of the formula. */
-	double dval3; /**< The third double value of the formula. */
-	int row1; /**< The row coordinate of the first operand. */
-	int col1; /**< The column coordinate of the first operand. */
-	int row2; /**< The row coordinate of the second operand. */
-	int col2; /**< The column coordinate of the second operand. */
-	std::string operation; /**< The operation string. */
-	bool digits; /**< Flag indicating if the formula contains digit placeholders. */
-	bool courdinates; /**< Flag indicating if the formula contains row/column placeholders. */
-	bool mixed; /**< Flag indicating if the formula contains a mix of digits and placeholders. */
-	bool whosFirst; /**< Flag indicating if the formula starts with row/column placeholders. */
+	static const size_t MAX_STACK = 16; /**< The deepest value stack evaluated without allocating. */
+	static const size_t MAX_LOCAL_CODE = 64; /**< The longest expression written for file output without allocating. */
+
+	const Expression* expression; /**< The compiled formula, owned by the pool it was interned in. */
+	int row; /**< The row index of the formula. */
+	int col; /**< The column index of the formula. */
+	mutable Value cached; /**< The result of the last evaluation. */
+	mutable bool evaluating; /**< Whether the formula is being evaluated, to stop at references back to it. */
+	mutable bool dirty; /**< Whether the cached result is missing or out of date. */
 };
\ No newline at end of file
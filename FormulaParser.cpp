@@ -0,0 +1,321 @@
+#include "FormulaParser.h"
+#include <charconv>
+#include <climits>
+#include <cctype>
+#include <algorithm>
+#include <cstring>
+
+static const char* const FUNCTIONS[] = { "SUM", "AVG", "MIN", "MAX", "COUNT" }; /**< The names of the aggregate functions. */
+static const OpCode FUNCTION_CODES[] = { OP_SUM, OP_AVERAGE, OP_MIN, OP_MAX, OP_COUNT }; /**< The operations of the aggregate functions. */
+static const size_t FUNCTION_COUNT = sizeof(FUNCTIONS) / sizeof(FUNCTIONS[0]); /**< The number of aggregate functions. */
+
+/**
+ * @brief Constructor for the FormulaParser class.
+ * @param expression The expression, the part of the formula after the '='.
+ */
+FormulaParser::FormulaParser(std::string_view expression) : expression(expression), position(0), code(nullptr) {}
+
+/**
+ * @brief Parses the whole expression.
+ * @details Anything left after the expression, like an unmatched ')', makes it invalid.
+ * @param code Receives the instructions, cleared if the expression is invalid.
+ * @return `true` if the expression is valid, `false` otherwise.
+ */
+bool FormulaParser::parse(std::vector<Instruction>& code) {
+	code.clear();
+	this->code = &code;
+	this->position = 0;
+	if (!this->parseExpression(0, 0) || this->nextChar() != '\0') {
+		code.clear();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Retrieves how strongly an operation binds its operands.
+ * @param op The operation.
+ * @return One of COMPARISON, ADDITIVE, MULTIPLICATIVE, UNARY and OPERAND.
+ */
+int FormulaParser::precedence(const OpCode op) {
+	switch (op) {
+	case OP_ADD:
+	case OP_SUBTRACT:
+		return ADDITIVE;
+	case OP_MULTIPLY:
+	case OP_DIVIDE:
+		return MULTIPLICATIVE;
+	case OP_LESS:
+	case OP_GREATER:
+	case OP_LESS_EQUAL:
+	case OP_GREATER_EQUAL:
+	case OP_EQUAL:
+	case OP_NOT_EQUAL:
+		return COMPARISON;
+	case OP_NEGATE:
+		return UNARY;
+	default:
+		return OPERAND;
+	}
+}
+
+/**
+ * @brief Retrieves how an operation is written in a formula.
+ * @param op The operation.
+ * @return The operator or the function name, an empty string for the push operations.
+ */
+const char* FormulaParser::spelling(const OpCode op) {
+	static const char* const OPERATORS[] = { "+", "-", "*", "/", "<", ">", "<=", ">=", "==", "!=", "-" };
+	if (op >= OP_ADD && op <= OP_NEGATE) {
+		return OPERATORS[op - OP_ADD];
+	}
+	for (size_t i = 0; i < FUNCTION_COUNT; i++) {
+		if (FUNCTION_CODES[i] == op) {
+			return FUNCTIONS[i];
+		}
+	}
+	return "";
+}
+
+/**
+ * @brief Parses an expression whose operators all bind stronger than a given precedence.
+ * @details The right operand of a binary operator is parsed with the precedence of the operator,
+ * so an operator of the same precedence ends it and is applied afterwards, left to right.
+ * @param minPrecedence The operators of this precedence or weaker end the expression.
+ * @param depth The nesting depth of the expression.
+ * @return `true` if an expression was parsed, `false` otherwise or if it nests deeper than MAX_DEPTH.
+ */
+bool FormulaParser::parseExpression(const int minPrecedence, const size_t depth) {
+	if (depth > MAX_DEPTH || !this->parseOperand(depth)) {
+		return false;
+	}
+	Instruction instruction;
+	size_t length = 0;
+	while (this->peekOperator(instruction.op, length) && precedence(instruction.op) > minPrecedence) {
+		this->position += length;
+		if (!this->parseExpression(precedence(instruction.op), depth + 1)) {
+			return false;
+		}
+		this->code->push_back(instruction);
+	}
+	return true;
+}
+
+/**
+ * @brief Parses an operand, a parenthesized expression or a unary operator applied to an operand.
+ * @details A unary operator binds stronger than every binary operator, "-2*3" is "(-2)*3".
+ * @param depth The nesting depth of the operand.
+ * @return `true` if an operand was parsed, `false` otherwise.
+ */
+bool FormulaParser::parseOperand(const size_t depth) {
+	Instruction instruction;
+	char c = this->nextChar();
+	if (c == '(') {
+		this->position++;
+		if (!this->parseExpression(0, depth + 1) || this->nextChar() != ')') {
+			return false;
+		}
+		this->position++;
+		return true;
+	}
+	if (c == '-' || c == '+') {
+		this->position++;
+		if (!this->parseExpression(UNARY, depth + 1)) {
+			return false;
+		}
+		if (c == '-') {
+			instruction.op = OP_NEGATE;
+			this->code->push_back(instruction);
+		}
+		return true;
+	}
+	if (c == 'R') {
+		instruction.op = OP_PUSH_CELL;
+		if (!this->readCell(instruction.row, instruction.col)) {
+			return false;
+		}
+	}
+	else if (std::isupper(static_cast<unsigned char>(c))) {
+		return this->parseFunction();
+	}
+	else if (!this->readNumber(instruction.number)) {
+		return false;
+	}
+	this->code->push_back(instruction);
+	return true;
+}
+
+/**
+ * @brief Parses an aggregate function applied to a range.
+ * @details The corners of the range may be given in any order, the range is stored with its
+ * top left corner first.
+ * @return `true` if a function was parsed, `false` otherwise.
+ */
+bool FormulaParser::parseFunction() {
+	char name[8];
+	size_t length = 0;
+	while (std::isupper(static_cast<unsigned char>(this->nextChar()))) {
+		if (length == sizeof(name) - 1) {
+			return false;
+		}
+		name[length++] = this->expression[this->position++];
+	}
+	name[length] = '\0';
+	size_t function = 0;
+	while (function < FUNCTION_COUNT && std::strcmp(FUNCTIONS[function], name) != 0) {
+		function++;
+	}
+	CellRange corners;
+	if (function == FUNCTION_COUNT || this->nextChar() != '(') {
+		return false;
+	}
+	this->position++;
+	if (!this->readCell(corners.top, corners.left) || this->nextChar() != ':') {
+		return false;
+	}
+	this->position++;
+	if (!this->readCell(corners.bottom, corners.right) || this->nextChar() != ')') {
+		return false;
+	}
+	this->position++;
+
+	Instruction instruction;
+	instruction.op = FUNCTION_CODES[function];
+	instruction.range.top = std::min(corners.top, corners.bottom);
+	instruction.range.bottom = std::max(corners.top, corners.bottom);
+	instruction.range.left = std::min(corners.left, corners.right);
+	instruction.range.right = std::max(corners.left, corners.right);
+	this->code->push_back(instruction);
+	return true;
+}
+
+/**
+ * @brief Recognises the binary operator at the current position without consuming it.
+ * @details The two characters of "<=", ">=", "==" and "!=" may be separated by spaces.
+ * @param op Receives the operation.
+ * @param length Receives the number of characters of the operator, including inner spaces.
+ * @return `true` if a binary operator follows, `false` otherwise.
+ */
+bool FormulaParser::peekOperator(OpCode& op, size_t& length) {
+	char c = this->nextChar();
+	length = 1;
+	switch (c) {
+	case '+':
+		op = OP_ADD;
+		return true;
+	case '-':
+		op = OP_SUBTRACT;
+		return true;
+	case '*':
+		op = OP_MULTIPLY;
+		return true;
+	case '/':
+		op = OP_DIVIDE;
+		return true;
+	case '<':
+	case '>':
+	case '=':
+	case '!':
+		break;
+	default:
+		return false;
+	}
+	size_t second = this->position + 1;
+	while (second < this->expression.length() && this->expression[second] == ' ') {
+		second++;
+	}
+	bool equals = second < this->expression.length() && this->expression[second] == '=';
+	if (equals) {
+		length = second - this->position + 1;
+	}
+	switch (c) {
+	case '<':
+		op = equals ? OP_LESS_EQUAL : OP_LESS;
+		return true;
+	case '>':
+		op = equals ? OP_GREATER_EQUAL : OP_GREATER;
+		return true;
+	case '=':
+		op = OP_EQUAL;
+		return equals;
+	default:
+		op = OP_NOT_EQUAL;
+		return equals;
+	}
+}
+
+/**
+ * @brief Skips spaces.
+ * @return The character at the new position, or '\0' at the end of the expression.
+ */
+char FormulaParser::nextChar() {
+	while (this->position < this->expression.length() && this->expression[this->position] == ' ') {
+		this->position++;
+	}
+	return this->position < this->expression.length() ? this->expression[this->position] : '\0';
+}
+
+/**
+ * @brief Reads an unsigned number, spaces between its digits are ignored.
+ * @param value Receives the number.
+ * @return `true` if a number with at least one digit and at most one '.' was read, `false` otherwise.
+ */
+bool FormulaParser::readNumber(double& value) {
+	char digits[128];
+	size_t count = 0;
+	bool dot = false;
+	bool digit = false;
+	char c = this->nextChar();
+	while (std::isdigit(static_cast<unsigned char>(c)) || (c == '.' && !dot)) {
+		if (count == sizeof(digits)) {
+			return false;
+		}
+		dot = dot || c == '.';
+		digit = digit || c != '.';
+		digits[count++] = c;
+		this->position++;
+		c = this->nextChar();
+	}
+	return digit && std::from_chars(digits, digits + count, value).ec == std::errc();
+}
+
+/**
+ * @brief Reads the digits of a row or column index.
+ * @param value Receives the index.
+ * @return `true` if at least one digit was read and the index fits in an int, `false` otherwise.
+ */
+bool FormulaParser::readIndex(int& value) {
+	long long index = 0;
+	char c = this->nextChar();
+	if (!std::isdigit(static_cast<unsigned char>(c))) {
+		return false;
+	}
+	while (std::isdigit(static_cast<unsigned char>(c))) {
+		index = index * 10 + (c - '0');
+		if (index > INT_MAX) {
+			return false;
+		}
+		this->position++;
+		c = this->nextChar();
+	}
+	value = static_cast<int>(index);
+	return true;
+}
+
+/**
+ * @brief Reads a cell reference "R<row>C<col>".
+ * @param row Receives the row.
+ * @param col Receives the column.
+ * @return `true` if a cell reference was read, `false` otherwise.
+ */
+bool FormulaParser::readCell(int& row, int& col) {
+	if (this->nextChar() != 'R') {
+		return false;
+	}
+	this->position++;
+	if (!this->readIndex(row) || this->nextChar() != 'C') {
+		return false;
+	}
+	this->position++;
+	return this->readIndex(col);
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include "Instruction.h"
+
+/**
+ * @class FormulaParser
+ * @brief Parses the expression of a formula straight into its compiled instructions.
+ *
+ * An expression is made of numbers, cell references "R<row>C<col>", aggregate functions
+ * "<FUNCTION>(<cell>:<cell>)", parentheses, unary '-' and '+', the arithmetic operators and the
+ * comparisons <, >, <=, >=, == and !=. Comparisons bind weakest, then '+' and '-', then '*' and '/',
+ * and all binary operators are left associative. The expression is read in a single pass by
+ * precedence climbing and every operand and operator is emitted in postfix order as soon as it is
+ * complete, spaces are skipped as they are met.
+ */
+class FormulaParser {
+public:
+	static const int COMPARISON = 1; /**< The precedence of the comparisons. */
+	static const int ADDITIVE = 2; /**< The precedence of '+' and '-'. */
+	static const int MULTIPLICATIVE = 3; /**< The precedence of '*' and '/'. */
+	static const int UNARY = 4; /**< The precedence of the unary minus. */
+	static const int OPERAND = 5; /**< The precedence of numbers, cell references and functions. */
+
+	/**
+	 * @brief Constructs a FormulaParser object for an expression.
+	 * @param expression The expression, the part of the formula after the '='.
+	 */
+	explicit FormulaParser(std::string_view expression);
+
+	/**
+	 * @brief Parses the whole expression.
+	 * @param code Receives the instructions, cleared if the expression is invalid.
+	 * @return `true` if the expression is valid, `false` otherwise.
+	 */
+	bool parse(std::vector<Instruction>& code);
+
+	/**
+	 * @brief Retrieves how strongly an operation binds its operands.
+	 * @param op The operation.
+	 * @return One of COMPARISON, ADDITIVE, MULTIPLICATIVE, UNARY and OPERAND.
+	 */
+	static int precedence(const OpCode op);
+
+	/**
+	 * @brief Retrieves how an operation is written in a formula.
+	 * @param op The operation.
+	 * @return The operator or the function name, an empty string for the push operations.
+	 */
+	static const char* spelling(const OpCode op);
+
+private:
+	/**
+	 * @brief Parses an expression whose operators all bind stronger than a given precedence.
+	 * @param minPrecedence The operators of this precedence or weaker end the expression.
+	 * @param depth The nesting depth of the expression.
+	 * @return `true` if an expression was parsed, `false` otherwise.
+	 */
+	bool parseExpression(const int minPrecedence, const size_t depth);
+
+	/**
+	 * @brief Parses an operand, a parenthesized expression or a unary operator applied to an operand.
+	 * @param depth The nesting depth of the operand.
+	 * @return `true` if an operand was parsed, `false` otherwise.
+	 */
+	bool parseOperand(const size_t depth);
+
+	/**
+	 * @brief Parses an aggregate function applied to a range.
+	 * @return `true` if a function was parsed, `false` otherwise.
+	 */
+	bool parseFunction();
+
+	/**
+	 * @brief Recognises the binary operator at the current position without consuming it.
+	 * @param op Receives the operation.
+	 * @param length Receives the number of characters of the operator, including inner spaces.
+	 * @return `true` if a binary operator follows, `false` otherwise.
+	 */
+	bool peekOperator(OpCode& op, size_t& length);
+
+	/**
+	 * @brief Skips spaces.
+	 * @return The character at the new position, or '\0' at the end of the expression.
+	 */
+	char nextChar();
+
+	/**
+	 * @brief Reads an unsigned number, spaces between its digits are ignored.
+	 * @param value Receives the number.
+	 * @return `true` if a number with at least one digit and at most one '.' was read, `false` otherwise.
+	 */
+	bool readNumber(double& value);
+
+	/**
+	 * @brief Reads the digits of a row or column index.
+	 * @param value Receives the index.
+	 * @return `true` if at least one digit was read and the index fits in an int, `false` otherwise.
+	 */
+	bool readIndex(int& value);
+
+	/**
+	 * @brief Reads a cell reference "R<row>C<col>".
+	 * @param row Receives the row.
+	 * @param col Receives the column.
+	 * @return `true` if a cell reference was read, `false` otherwise.
+	 */
+	bool readCell(int& row, int& col);
+
+	static const size_t MAX_DEPTH = 256; /**< The deepest nesting of parentheses and operators accepted. */
+
+	std::string_view expression; /**< The expression being parsed. */
+	size_t position; /**< The offset of the next character to read. */
+	std::vector<Instruction>* code; /**< The instructions emitted so far. */
+};
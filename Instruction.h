@@ -0,0 +1,39 @@
+#pragma once
+#include "CellRange.h"
+
+/**
+ * @enum OpCode
+ * @brief Represents the operations of a compiled formula.
+ */
+enum OpCode {
+	OP_PUSH_NUMBER, /**< Pushes a number literal. */
+	OP_PUSH_CELL, /**< Pushes the value of a referenced cell. */
+	OP_ADD, /**< Replaces the two topmost values with their sum. */
+	OP_SUBTRACT, /**< Replaces the two topmost values with their difference. */
+	OP_MULTIPLY, /**< Replaces the two topmost values with their product. */
+	OP_DIVIDE, /**< Replaces the two topmost values with their quotient. */
+	OP_LESS, /**< Replaces the two topmost values with 1 if the first is smaller, 0 otherwise. */
+	OP_GREATER, /**< Replaces the two topmost values with 1 if the first is bigger, 0 otherwise. */
+	OP_LESS_EQUAL, /**< Replaces the two topmost values with 1 if the first is not bigger, 0 otherwise. */
+	OP_GREATER_EQUAL, /**< Replaces the two topmost values with 1 if the first is not smaller, 0 otherwise. */
+	OP_EQUAL, /**< Replaces the two topmost values with 1 if they are equal, 0 otherwise. */
+	OP_NOT_EQUAL, /**< Replaces the two topmost values with 1 if they differ, 0 otherwise. */
+	OP_NEGATE, /**< Replaces the topmost value with its negation. */
+	OP_SUM, /**< Pushes the sum of the numbers of a range. */
+	OP_AVERAGE, /**< Pushes the average of the numbers of a range, an error if it has none. */
+	OP_MIN, /**< Pushes the smallest number of a range, 0 if it has none. */
+	OP_MAX, /**< Pushes the biggest number of a range, 0 if it has none. */
+	OP_COUNT /**< Pushes the number of numbers of a range. */
+};
+
+/**
+ * @struct Instruction
+ * @brief A single instruction of a compiled formula, evaluated on a value stack.
+ */
+struct Instruction {
+	OpCode op = OP_PUSH_NUMBER; /**< The operation. */
+	int row = 0; /**< The row of the cell pushed by OP_PUSH_CELL, an offset from the row of the formula once the expression is stored. */
+	int col = 0; /**< The column of the cell pushed by OP_PUSH_CELL, an offset from the column of the formula once the expression is stored. */
+	double number = 0; /**< The literal pushed by OP_PUSH_NUMBER. */
+	CellRange range; /**< The range read by the aggregate operations, always in absolute coordinates. */
+};
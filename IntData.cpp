@@ -1,4 +1,5 @@
 #include "IntData.h"
+#include <charconv>
 
 /**
  * @brief Default constructor for IntData.
@@ -31,6 +32,32 @@ std::string IntData::stringifyFile() const
 	return std::to_string(this->val);
 }
 
+/**
+ * @brief Writes the integer value into a caller-supplied buffer.
+ * @details The text is the same as the one of stringify(), produced with std::to_chars.
+ * @param buffer The buffer to write to.
+ * @param size The size of the buffer.
+ * @return The length of the string representation.
+ */
+size_t IntData::format(char* buffer, const size_t size) const
+{
+	char text[16];
+	std::to_chars_result result = std::to_chars(text, text + sizeof(text), this->val);
+	return copyText(buffer, size, text, result.ptr - text);
+}
+
+/**
+ * @brief Writes the integer value for file output into a caller-supplied buffer.
+ * @details The file holds the same text as the console, see format().
+ * @param buffer The buffer to write to.
+ * @param size The size of the buffer.
+ * @return The length of the string representation.
+ */
+size_t IntData::formatFile(char* buffer, const size_t size) const
+{
+	return this->format(buffer, size);
+}
+
 /**
  * @brief Retrieves the data type of the IntData object.
  * @return The data type of the object (INT).
@@ -39,6 +66,17 @@ DataType IntData::getType() const {
 	return this->type;
 }
 
+/**
+ * @brief Evaluates the integer value to a typed number.
+ * @return The value as an INT_VALUE.
+ */
+Value IntData::evaluate(const Table&) const {
+	Value value;
+	value.type = INT_VALUE;
+	value.ival = this->val;
+	return value;
+}
+
 /**
  * @brief Retrieves the integer value stored in IntData.
  * @return The integer value.
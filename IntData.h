@@ -30,12 +30,35 @@ public:
 	 */
 	virtual std::string stringifyFile() const override;
 
+	/**
+	 * @brief Writes the string representation of the IntData object into a caller-supplied buffer.
+	 * @param buffer The buffer to write to.
+	 * @param size The size of the buffer.
+	 * @return The length of the whole string representation.
+	 */
+	virtual size_t format(char* buffer, const size_t size) const override;
+
+	/**
+	 * @brief Writes the string representation of the IntData object for file output into a caller-supplied buffer.
+	 * @param buffer The buffer to write to.
+	 * @param size The size of the buffer.
+	 * @return The length of the whole string representation for file output.
+	 */
+	virtual size_t formatFile(char* buffer, const size_t size) const override;
+
 	/**
 	 * @brief Retrieves the data type of the IntData object.
 	 * @return The data type of the IntData object (DataType::INT).
 	 */
 	virtual DataType getType() const override;
 
+	/**
+	 * @brief Evaluates the IntData object to a typed number.
+	 * @param table Unused, the value does not depend on other cells.
+	 * @return The value as an INT_VALUE.
+	 */
+	virtual Value evaluate(const Table& table) const override;
+
 	/**
 	 * @brief Retrieves the value of the IntData object.
 	 * @return The value of the IntData object.
@@ -0,0 +1,79 @@
+#include "SnapshotReader.h"
+#include "SnapshotWriter.h"
+#include "SnapshotRecord.h"
+#include <cstring>
+
+/**
+ * @brief Constructs a SnapshotReader object for the given file.
+ *
+ * The file is opened in binary mode and its header is compared with the one this build would
+ * write, a snapshot of another version, byte order or structure layout is rejected.
+ *
+ * @param filename The name of the snapshot file.
+ */
+SnapshotReader::SnapshotReader(const std::string& filename) : in(filename, std::ios::binary), size(0), remaining(0), ok(false) {
+    if (!this->in.is_open()) {
+        return;
+    }
+    this->in.seekg(0, std::ios::end);
+    std::streamoff end = this->in.tellg();
+    this->in.seekg(0, std::ios::beg);
+    if (end <= 0) {
+        return;
+    }
+    this->size = static_cast<size_t>(end);
+    this->remaining = this->size;
+    this->ok = true;
+    const uint32_t expected[] = { SnapshotWriter::MAGIC, SnapshotWriter::VERSION, 0x01020304, sizeof(StoredInstruction), sizeof(StoredValue), sizeof(size_t) };
+    uint32_t header[sizeof(expected) / sizeof(expected[0])];
+    this->readBytes(header, sizeof(header));
+    if (std::memcmp(header, expected, sizeof(header)) != 0) {
+        this->fail();
+    }
+}
+
+/**
+ * @brief Checks if everything read so far was valid.
+ *
+ * @return True if the reader did not fail, False otherwise.
+ */
+bool SnapshotReader::good() const {
+    return this->ok;
+}
+
+/**
+ * @brief Marks the snapshot as invalid.
+ */
+void SnapshotReader::fail() {
+    this->ok = false;
+    this->remaining = 0;
+}
+
+/**
+ * @brief Reads raw bytes from the snapshot.
+ *
+ * A read past the end of the file, or a failed read, makes the reader fail.
+ *
+ * @param data Receives the bytes, zeros if the reader failed.
+ * @param size The number of bytes.
+ */
+void SnapshotReader::readBytes(void* data, const size_t size) {
+    if (size == 0) {
+        return;
+    }
+    if (this->ok && size <= this->remaining && this->in.read(static_cast<char*>(data), size)) {
+        this->remaining -= size;
+        return;
+    }
+    this->fail();
+    std::memset(data, 0, size);
+}
+
+/**
+ * @brief Retrieves the size of the snapshot file.
+ *
+ * @return The number of bytes of the file.
+ */
+size_t SnapshotReader::bytes() const {
+    return this->size;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class SnapshotReader
+ * @brief Reads the binary snapshot of a table written by SnapshotWriter.
+ *
+ * Blocks of values are read straight into the arrays that keep them, without parsing. Every read
+ * is checked against the size of the file, so a truncated or foreign file makes the reader fail
+ * instead of allocating or reading past its end. Once the reader failed every later read yields
+ * zeros.
+ */
+class SnapshotReader {
+public:
+    /**
+     * @brief Constructs a SnapshotReader object and checks the header of the snapshot.
+     * @param filename The name of the snapshot file.
+     */
+    explicit SnapshotReader(const std::string& filename);
+
+    /**
+     * @brief Checks if everything read so far was valid.
+     * @return `true` if the reader did not fail, `false` otherwise.
+     */
+    bool good() const;
+
+    /**
+     * @brief Marks the snapshot as invalid, for values that are out of range.
+     */
+    void fail();
+
+    /**
+     * @brief Reads raw bytes from the snapshot.
+     * @param data Receives the bytes, zeros if the reader failed.
+     * @param size The number of bytes.
+     */
+    void readBytes(void* data, const size_t size);
+
+    /**
+     * @brief Reads a value from the snapshot.
+     * @return The value, zero if the reader failed.
+     */
+    template <typename T>
+    T readValue() {
+        T value = T();
+        this->readBytes(&value, sizeof(T));
+        return value;
+    }
+
+    /**
+     * @brief Reads the elements of an array from the snapshot.
+     * @param values Receives the elements, it is left empty if they are not all in the file.
+     * @param count The number of elements.
+     * @return `true` if the elements were read, `false` otherwise.
+     */
+    template <typename T>
+    bool readArray(std::vector<T>& values, const size_t count) {
+        values.clear();
+        if (!this->ok || count > this->remaining / sizeof(T)) {
+            this->fail();
+            return false;
+        }
+        values.resize(count);
+        this->readBytes(values.data(), count * sizeof(T));
+        return this->ok;
+    }
+
+    /**
+     * @brief Retrieves the size of the snapshot file.
+     * @return The number of bytes of the file.
+     */
+    size_t bytes() const;
+
+private:
+    std::ifstream in; /**< The snapshot file. */
+    size_t size; /**< The size of the file. */
+    size_t remaining; /**< The number of bytes not read yet. */
+    bool ok; /**< Whether everything read so far was valid. */
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * @struct StoredInstruction
+ * @brief An Instruction as it is laid out in a snapshot.
+ *
+ * The operation is a plain integer, so a snapshot can be checked before any of its values is
+ * used as an OpCode. The fields leave no padding, every byte of the record is written.
+ */
+struct StoredInstruction {
+	uint32_t op = 0; /**< The operation, an OpCode. */
+	int32_t row = 0; /**< The row of the cell pushed by OP_PUSH_CELL, relative to the formula. */
+	int32_t col = 0; /**< The column of the cell pushed by OP_PUSH_CELL, relative to the formula. */
+	int32_t top = 0; /**< The first row of the range of an aggregate. */
+	int32_t left = 0; /**< The first column of the range of an aggregate. */
+	int32_t bottom = 0; /**< The last row of the range of an aggregate. */
+	int32_t right = 0; /**< The last column of the range of an aggregate. */
+	uint32_t reserved = 0; /**< Always 0, aligns the literal. */
+	double number = 0; /**< The literal pushed by OP_PUSH_NUMBER. */
+};
+
+/**
+ * @struct StoredValue
+ * @brief A Value as it is laid out in a snapshot, with its type as a plain integer.
+ */
+struct StoredValue {
+	uint32_t type = 0; /**< The type of the value, a ValueType. */
+	int32_t ival = 0; /**< The value of an INT_VALUE. */
+	double dval = 0; /**< The value of a DOUBLE_VALUE. */
+};
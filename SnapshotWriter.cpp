@@ -0,0 +1,66 @@
+#include "SnapshotWriter.h"
+#include "SnapshotRecord.h"
+#include <cstring>
+
+/**
+ * @brief Constructs a SnapshotWriter object for the given file.
+ *
+ * The header holds the magic number, the version, a marker of the byte order and the sizes of the
+ * structures stored as they are, which SnapshotReader compares with its own.
+ *
+ * @param filename The name of the file to replace.
+ */
+SnapshotWriter::SnapshotWriter(const std::string& filename) : file(filename), buffer(BUFFER_BYTES), used(0) {
+    const uint32_t header[] = { MAGIC, VERSION, 0x01020304, sizeof(StoredInstruction), sizeof(StoredValue), sizeof(size_t) };
+    this->writeBytes(header, sizeof(header));
+}
+
+/**
+ * @brief Checks if the file could be created.
+ *
+ * @return True if the file is open, False otherwise.
+ */
+bool SnapshotWriter::is_open() const {
+    return this->file.is_open();
+}
+
+/**
+ * @brief Appends raw bytes to the snapshot.
+ *
+ * Small blocks are copied into the buffer, a block that does not fit in an empty buffer is written
+ * to the file directly.
+ *
+ * @param data The bytes.
+ * @param size The number of bytes.
+ */
+void SnapshotWriter::writeBytes(const void* data, const size_t size) {
+    if (size > this->buffer.size() - this->used) {
+        this->flush();
+    }
+    if (size >= this->buffer.size()) {
+        this->file.write(static_cast<const char*>(data), size);
+        return;
+    }
+    if (size > 0) {
+        std::memcpy(this->buffer.data() + this->used, data, size);
+        this->used += size;
+    }
+}
+
+/**
+ * @brief Writes the rest of the buffer and replaces the file with the snapshot.
+ *
+ * @return True if the file was replaced, False otherwise.
+ */
+bool SnapshotWriter::commit() {
+    this->flush();
+    return this->file.commit();
+}
+
+/**
+ * @brief Hands the buffered bytes to the file.
+ */
+void SnapshotWriter::flush() {
+    this->file.write(this->buffer.data(), this->used);
+    this->used = 0;
+}
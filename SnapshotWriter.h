@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "FileWriter.h"
+
+/**
+ * @class SnapshotWriter
+ * @brief Writes the binary snapshot of a table.
+ *
+ * A snapshot is a header followed by blocks of raw values, in the byte order and layout of the
+ * machine that wrote it. The header records that layout, so a snapshot is only read back where its
+ * values mean the same. The data is collected in a large buffer and handed to a FileWriter, so the
+ * file is replaced atomically once the whole snapshot is written.
+ */
+class SnapshotWriter {
+public:
+    static const uint32_t MAGIC = 0x50414E53; /**< The first bytes of every snapshot, "SNAP" in little endian. */
+    static const uint32_t VERSION = 3; /**< The version of the snapshot layout. */
+
+    /**
+     * @brief Constructs a SnapshotWriter object and writes the header.
+     * @param filename The name of the file to replace.
+     */
+    explicit SnapshotWriter(const std::string& filename);
+
+    /**
+     * @brief Checks if the file could be created.
+     * @return `true` if the file is open, `false` otherwise.
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Appends raw bytes to the snapshot.
+     * @param data The bytes.
+     * @param size The number of bytes.
+     */
+    void writeBytes(const void* data, const size_t size);
+
+    /**
+     * @brief Appends a value to the snapshot.
+     * @param value The value, it must be trivially copyable.
+     */
+    template <typename T>
+    void writeValue(const T& value) {
+        this->writeBytes(&value, sizeof(T));
+    }
+
+    /**
+     * @brief Appends the elements of an array to the snapshot, without its length.
+     * @param values The array, its elements must be trivially copyable.
+     */
+    template <typename T>
+    void writeArray(const std::vector<T>& values) {
+        this->writeBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    /**
+     * @brief Writes the rest of the buffer and replaces the file with the snapshot.
+     * @return `true` if the file was replaced, `false` if it was left as it was.
+     */
+    bool commit();
+
+private:
+    /**
+     * @brief Hands the buffered bytes to the file.
+     */
+    void flush();
+
+    static const size_t BUFFER_BYTES = 1 << 20; /**< The size of the buffer the snapshot is collected in before it is written. */
+
+    FileWriter file; /**< The file the snapshot replaces. */
+    std::vector<char> buffer; /**< The bytes not written yet. */
+    size_t used; /**< The number of bytes in the buffer. */
+};
@@ -1,16 +1,17 @@
 #include "StringData.h"
+#include "Confirmer.h"
 
 /**
  * @brief Default constructor for StringData.
  * @details Initializes the value to an empty string.
  */
-StringData::StringData() : StringData("") {}
+StringData::StringData() : StringData(std::string_view()) {}
 
 /**
  * @brief Constructor for StringData.
- * @param val The string value to be stored.
+ * @param val The string value to refer to.
  */
-StringData::StringData(const std::string& val) :val(val) {
+StringData::StringData(std::string_view val) :val(val) {
 	this->type = STRING;
 }
 
@@ -19,7 +20,7 @@ StringData::StringData(const std::string& val) :val(val) {
  * @return The string value itself.
  */
 std::string StringData::stringify() const {
-	return this->val;
+	return std::string(this->val);
 }
 
 /**
@@ -30,7 +31,7 @@ std::string StringData::stringifyFile() const
 {
 	std::string tmp = "\"";
 	if (this->val.empty()) {
-		return this->val;
+		return std::string();
 	}
 	else if (this->val[0] == '\"') {
 		tmp += '\\';
@@ -46,6 +47,50 @@ std::string StringData::stringifyFile() const
 	return tmp;
 }
 
+/**
+ * @brief Writes the string value into a caller-supplied buffer.
+ * @param buffer The buffer to write to.
+ * @param size The size of the buffer.
+ * @return The length of the string value.
+ */
+size_t StringData::format(char* buffer, const size_t size) const
+{
+	return copyText(buffer, size, this->val.data(), this->val.size());
+}
+
+/**
+ * @brief Writes the string value for file output into a caller-supplied buffer.
+ * @details The text is the same as the one of stringifyFile(), built without allocating.
+ * @param buffer The buffer to write to.
+ * @param size The size of the buffer.
+ * @return The length of the string value with its quotes and escapes, nothing is written if it does not fit.
+ */
+size_t StringData::formatFile(char* buffer, const size_t size) const
+{
+	if (this->val.empty()) {
+		return 0;
+	}
+	bool quoted = this->val[0] == '\"';
+	std::string_view text = quoted ? this->val.substr(0, this->val.size() - 1) : this->val;
+	size_t length = text.size() + (quoted ? 5 : 2);
+	if (length > size) {
+		return length;
+	}
+	char* end = buffer;
+	*end++ = '\"';
+	if (quoted) {
+		*end++ = '\\';
+	}
+	std::memcpy(end, text.data(), text.size());
+	end += text.size();
+	if (quoted) {
+		*end++ = '\\';
+		*end++ = '\"';
+	}
+	*end = '\"';
+	return length;
+}
+
 /**
  * @brief Retrieves the data type of the StringData object.
  * @return The data type of the object (STRING).
@@ -54,10 +99,32 @@ DataType StringData::getType() const {
 	return this->type;
 }
 
+/**
+ * @brief Evaluates the string value to a typed number.
+ * @details The string is classified like a cell of the input file, so a string that spells a
+ * number evaluates to that number.
+ * @return The number the string spells, or an ERROR_VALUE if it is not a number.
+ */
+Value StringData::evaluate(const Table&) const {
+	Value value;
+	Token token = Confirmer::classify(this->val);
+	if (token.type == INT_TOKEN) {
+		value.ival = token.ival;
+	}
+	else if (token.type == DOUBLE_TOKEN) {
+		value.type = DOUBLE_VALUE;
+		value.dval = token.dval;
+	}
+	else {
+		value.type = ERROR_VALUE;
+	}
+	return value;
+}
+
 /**
  * @brief Retrieves the string value stored in StringData.
  * @return The string value.
  */
 std::string StringData::getVal() const {
-	return this->val;
+	return std::string(this->val);
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include"Data.h"
+#include <string_view>
 
 /**
  * @class StringData
@@ -13,10 +14,11 @@ public:
 	StringData();
 
 	/**
-	 * @brief Constructs a StringData object with the specified string value.
+	 * @brief Constructs a StringData object that refers to the specified string value.
 	 * @param value The string value of the StringData object.
+	 * @note The characters are not copied and must outlive the StringData object.
 	 */
-	StringData(const std::string& value);
+	StringData(std::string_view value);
 
 	/**
 	 * @brief Converts the StringData object to a string representation.
@@ -30,12 +32,35 @@ public:
 	 */
 	virtual std::string stringifyFile() const override;
 
+	/**
+	 * @brief Writes the string representation of the StringData object into a caller-supplied buffer.
+	 * @param buffer The buffer to write to.
+	 * @param size The size of the buffer.
+	 * @return The length of the whole string representation.
+	 */
+	virtual size_t format(char* buffer, const size_t size) const override;
+
+	/**
+	 * @brief Writes the string representation of the StringData object for file output into a caller-supplied buffer.
+	 * @param buffer The buffer to write to.
+	 * @param size The size of the buffer.
+	 * @return The length of the whole string representation for file output.
+	 */
+	virtual size_t formatFile(char* buffer, const size_t size) const override;
+
 	/**
 	 * @brief Retrieves the data type of the StringData object.
 	 * @return The data type of the StringData object (DataType::STRING).
 	 */
 	virtual DataType getType() const override;
 
+	/**
+	 * @brief Evaluates the StringData object to a typed number.
+	 * @param table Unused, the value does not depend on other cells.
+	 * @return The number the string spells, or an ERROR_VALUE if it is not a number.
+	 */
+	virtual Value evaluate(const Table& table) const override;
+
 	/**
 	 * @brief Retrieves the value of the StringData object.
 	 * @return The value of the StringData object.
@@ -48,5 +73,5 @@ public:
 	~StringData() override {}
 
 private:
-	std::string val; /**< The string value of the StringData object. */
+	std::string_view val; /**< The string value of the StringData object. */
 };
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "StringPool.h"
+#include <cstring>
+
+/**
+ * @brief Default constructor for StringPool.
+ * @details Initializes a pool without strings.
+ */
+StringPool::StringPool() {}
+
+/**
+ * @brief Adds references to a string, storing it if it is not in the pool yet.
+ * @details A string shared by many cells, like one loaded from a snapshot, gets all its references at once.
+ * @param value The string to intern.
+ * @param count The number of references to add.
+ * @return The view of the stored copy, an empty view for an empty string.
+ */
+std::string_view StringPool::intern(std::string_view value, const size_t count) {
+	if (value.empty()) {
+		return std::string_view();
+	}
+	auto found = this->references.find(value);
+	if (found != this->references.end()) {
+		found->second += count;
+		return found->first;
+	}
+	char* stored = static_cast<char*>(this->arena.allocate(value.size()));
+	std::memcpy(stored, value.data(), value.size());
+	std::string_view view(stored, value.size());
+	try {
+		this->references.emplace(view, count);
+	}
+	catch (std::bad_alloc& e) {
+		this->arena.deallocate(stored, value.size());
+		throw;
+	}
+	return view;
+}
+
+/**
+ * @brief Drops a reference to an interned string, freeing it with the last one.
+ * @param value The view returned by intern().
+ */
+void StringPool::release(std::string_view value) {
+	if (value.empty()) {
+		return;
+	}
+	auto found = this->references.find(value);
+	if (found == this->references.end() || --found->second > 0) {
+		return;
+	}
+	this->references.erase(found);
+	this->arena.deallocate(const_cast<char*>(value.data()), value.size());
+}
+
+/**
+ * @brief Retrieves the number of distinct strings in the pool.
+ * @return The number of distinct strings.
+ */
+size_t StringPool::size() const {
+	return this->references.size();
+}
+
+/**
+ * @brief Lists the stored strings.
+ * @return The view of every stored string, in no particular order.
+ */
+std::vector<std::string_view> StringPool::entries() const {
+	std::vector<std::string_view> entries;
+	entries.reserve(this->references.size());
+	for (const auto& entry : this->references) {
+		entries.push_back(entry.first);
+	}
+	return entries;
+}
+
+/**
+ * @brief Computes the memory used by the pool.
+ * @details The lookup table is counted as its bucket array plus one node per string.
+ * @return The approximate number of bytes held by the characters and the lookup table.
+ */
+size_t StringPool::memoryUsage() const {
+	size_t node = sizeof(void*) + sizeof(std::pair<const std::string_view, size_t>) + sizeof(size_t);
+	return this->arena.memoryUsage() + this->references.bucket_count() * sizeof(void*) + this->references.size() * node;
+}
+
+/**
+ * @brief Removes all strings from the pool.
+ */
+void StringPool::clear() {
+	this->references.clear();
+	this->arena.release();
+}
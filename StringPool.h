@@ -0,0 +1,65 @@
+#pragma once
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Arena.h"
+
+/**
+ * @class StringPool
+ * @brief Stores every distinct string once and hands out views of the stored copy.
+ *
+ * Interning the same characters twice returns the same view, so two interned strings are
+ * equal exactly when their data pointers are. The characters are kept in an arena and are
+ * freed once the last cell referring to them releases them.
+ */
+class StringPool {
+public:
+	/**
+	 * @brief Constructs an empty StringPool object.
+	 */
+	StringPool();
+
+	StringPool(const StringPool&) = delete; /**< Disable copy constructor. */
+	StringPool& operator=(const StringPool&) = delete; /**< Disable assignment operator. */
+
+	/**
+	 * @brief Adds references to a string, storing it if it is not in the pool yet.
+	 * @param value The string to intern.
+	 * @param count The number of references to add.
+	 * @return The view of the stored copy, an empty view for an empty string.
+	 */
+	std::string_view intern(std::string_view value, const size_t count = 1);
+
+	/**
+	 * @brief Drops a reference to an interned string, freeing it with the last one.
+	 * @param value The view returned by intern().
+	 */
+	void release(std::string_view value);
+
+	/**
+	 * @brief Retrieves the number of distinct strings in the pool.
+	 * @return The number of distinct strings.
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief Lists the stored strings.
+	 * @return The view of every stored string, in no particular order.
+	 */
+	std::vector<std::string_view> entries() const;
+
+	/**
+	 * @brief Computes the memory used by the pool.
+	 * @return The approximate number of bytes held by the characters and the lookup table.
+	 */
+	size_t memoryUsage() const;
+
+	/**
+	 * @brief Removes all strings from the pool.
+	 */
+	void clear();
+
+private:
+	std::unordered_map<std::string_view, size_t> references; /**< The number of references to every stored string. */
+	Arena arena; /**< The memory of the stored characters. */
+};
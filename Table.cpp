@@ -1,146 +1,317 @@
 #include "Table.h"
+#include <unordered_map>
 
 /**
 	 * @brief Constructs the Table object.
 	 * @note This constructor is private to enforce the singleton pattern.
 	 */
-Table::Table() {
+Table::Table() : workers(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0), linked(false) {
 	std::cout << "Enter file path to load table: ";
 	std::string filepath;
 	while (true) {
 		std::cin >> filepath;
 		int size = filepath.size();
-		if (filepath[size - 1] != 't' || filepath[size - 2] != 'x' || filepath[size - 3] != 't') {
+		if ((filepath[size - 1] != 't' || filepath[size - 2] != 'x' || filepath[size - 3] != 't') && !isSnapshot(filepath)) {
 			std::cout << "Wrong file extension, enter again\n";
 		}
 		else break;
 	}
 	this->filepath = filepath;
-	int maxTokens = Confirmer::maxTokens(filepath);
-	int maxRows = Confirmer::maxRows(filepath);
-	this->maxCols = maxTokens;
-	this->maxRows = maxRows;
-	CSVReader reader(filepath, maxTokens);
-	std::vector<Data*> realRow;
-		while (reader.has_more_data()) {
-			std::vector<std::string> row = reader.get_tokens();
+	this->load(filepath);
+	std::cout << "Successfuly opened " << filepath << std::endl;
+}
 
-			if (row.empty()) {
-				continue;
+/**
+	 * @brief Loads the table from a file in a single pass.
+	 * @details Snapshots are loaded by loadSnapshot().
+	 * @param filepath The file path to load the table from.
+	 */
+void Table::load(const std::string& filepath)
+{
+	if (isSnapshot(filepath)) {
+		this->loadSnapshot(filepath);
+		return;
+	}
+	auto start = std::chrono::steady_clock::now();
+	this->maxRows = 0;
+	CSVReader reader(filepath, 0, true);
+	std::vector<std::string_view> chunks;
+	unsigned threads = std::thread::hardware_concurrency();
+	if (threads > 1) {
+		chunks = reader.get_chunks(threads);
+	}
+	size_t bytes = 0;
+	size_t width = 1;
+	size_t invalid = 0;
+	try {
+		if (chunks.size() > 1 && chunks[0].size() >= PARALLEL_CHUNK_BYTES) {
+			width = this->loadChunks(chunks, invalid);
+			for (size_t i = 0; i < chunks.size(); i++) {
+				bytes += chunks[i].size();
 			}
-			realRow.clear();
-			size_t i = 0;
+		}
+		else {
+			width = readRows(reader, true, this->data, invalid);
+			this->maxRows = reader.rows_read();
+			bytes = reader.bytes_read();
+		}
+	}
+	catch (std::bad_alloc& e) {
+		this->clean();
+	}
+	for (size_t i = 0; i < invalid; i++) {
+		std::cout << "Invalid data at given\n";
+	}
+	this->maxCols = width;
+	this->data.pad(width);
+	if (COLUMNAR_STORAGE) {
+		this->data.columnize();
+	}
+	this->recalculateAll();
+	this->widths.assign(this->data.getCols(), static_cast<size_t>(UNKNOWN_WIDTH));
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	double seconds = elapsed.count() > 0 ? elapsed.count() : 1e-9;
+	std::cout << "Loaded " << bytes << " bytes in " << seconds * 1000 << " ms ("
+		<< bytes / seconds / (1024 * 1024) << " MB/s), cells use " << this->data.memoryUsage() << " bytes\n";
+	std::cout << this->data.stringReport();
+}
+
+/**
+	 * @brief Loads the chunks of a file on one worker thread per chunk.
+	 * @details The workers only count the invalid tokens of their chunks, the counts are added up
+	 * once all of them have finished.
+	 * @param chunks The chunks of whole lines of the file, in file order.
+	 * @param invalid Receives the number of invalid tokens.
+	 * @return The number of tokens of the widest row.
+	 * @throws std::bad_alloc If a worker ran out of memory, the rows of all chunks are freed.
+	 */
+size_t Table::loadChunks(const std::vector<std::string_view>& chunks, size_t& invalid)
+{
+	std::vector<CellStore> parts(chunks.size());
+	std::vector<size_t> widths(chunks.size(), 1);
+	std::vector<size_t> lines(chunks.size(), 0);
+	std::vector<size_t> invalids(chunks.size(), 0);
+	std::vector<char> failed(chunks.size(), false);
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i < chunks.size(); i++) {
+		workers.emplace_back([&, i]() {
+			CSVReader reader(chunks[i], 0);
 			try {
-				for (i = 0; i < row.size(); i++) {
-					if (Confirmer::isNum(row[i])) {
-						realRow.push_back(new IntData(std::stoi(row[i])));
-					}
-					else if (Confirmer::isString(row[i])) {
-						std::string clean = "\"";
-						if (!row[i].empty() && row[i][1] == '\\') {
-							size_t j = 0;
-							while (row[i][j] == '"' || row[i][j] == '\\') {
-								j++;
-							}
-							for (size_t k = j; k < row[i].length(); k++) {
-								if (row[i][k] == '\\') {
-									break;
-								}
-								clean += row[i][k];
-							}
-							clean += '\"';
-						}
-						else if (!row[i].empty() && row[i][1] != '\\') {
-							clean = row[i].substr(1, row[i].length() - 2);
-						}
-
-						if (clean == "\"") {
-							realRow.push_back(new StringData(row[i]));
-						}
-						else realRow.push_back(new StringData(clean));
-					}
-					else if (Confirmer::isDouble(row[i])) {
-						realRow.push_back(new DoubleData(std::stod(row[i])));
-					}
-					else if (Confirmer::isFormula1(row[i])) {
-						std::vector<int> rows;
-						std::vector<int> cols;
-						std::string op = "";
-						Confirmer::extractData1(row[i], rows, op, cols);
-						realRow.push_back(new FormulaData(cols[0], rows[0], cols[1], rows[1], op));
-					}
-					else if (Confirmer::isFormula2(row[i])) {
-						double dval1 = 0;
-						double dval2 = 0;
-						std::string op = "";
-						Confirmer::extractData2(row[i], dval1, op, dval2);
-						realRow.push_back(new FormulaData(dval1, dval2, op));
-					}
-					else if (Confirmer::isFormula3(row[i])) {
-						double dval3 = 0;
-						int row1 = 0;
-						int col1 = 0;
-						std::string op = "";
-						bool whosFirst = Confirmer::extractData3(row[i], dval3, op, row1, col1);
-						realRow.push_back(new FormulaData(dval3, row1, col1, op, whosFirst));
-					}
-					else {
-						realRow.push_back(new StringData(""));
-						std::cout << "Invalid data at given\n";
-					}
-				}
+				widths[i] = readRows(reader, i + 1 == chunks.size(), parts[i], invalids[i]);
 			}
 			catch (std::bad_alloc& e) {
-				if (realRow.size() != 0) {
-					for (size_t i = 0; i < realRow.size(); i++) {
-						delete realRow[i];
-					}
-				}
-				this->clean();
+				failed[i] = true;
 			}
+			lines[i] = reader.rows_read();
+		});
+	}
+	for (size_t i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
 
-			this->data.push_back(realRow);
-		}
+	bool outOfMemory = false;
+	for (size_t i = 0; i < chunks.size(); i++) {
+		outOfMemory = outOfMemory || failed[i];
+		invalid += invalids[i];
+	}
+	if (outOfMemory) {
+		throw std::bad_alloc();
+	}
 
-	std::cout << "Successfuly opened " << filepath << std::endl;
+	size_t width = 1;
+	this->maxRows = 0;
+	for (size_t i = 0; i < parts.size(); i++) {
+		this->data.append(parts[i]);
+		this->maxRows += lines[i];
+		if (widths[i] > width) {
+			width = widths[i];
+		}
+	}
+	return width;
 }
 
 /**
-	 * @brief Cleans up the table by deleting all data objects.
+	 * @brief Reads all rows of a reader and converts their tokens into cells.
+	 * @param reader The reader to read from.
+	 * @param last Whether the reader reaches the end of the file.
+	 * @param rows Receives the rows.
+	 * @param invalid Counts the invalid tokens.
+	 * @return The number of tokens of the widest row.
+	 * @throws std::bad_alloc If there is not enough memory, the rows read so far are removed.
 	 */
-void Table::clean()
+size_t Table::readRows(CSVReader& reader, const bool last, CellStore& rows, size_t& invalid)
 {
-	for (size_t i = 0; i < this->data.size(); i++) {
-		for (size_t j = 0; j < this->data[i].size(); j++) {
-			delete this->data[i][j];
+	size_t width = 1;
+	try {
+		while (reader.has_more_data()) {
+			size_t before = reader.rows_read();
+			const std::vector<std::string_view>& row = reader.get_token_views();
+			if (!last && reader.rows_read() == before) {
+				break;
+			}
+			rows.addRow();
+			for (size_t i = 0; i < row.size(); i++) {
+				Token token = parseCell(row[i], invalid);
+				rows.add(token);
+			}
+			if (row.size() > width) {
+				width = row.size();
+			}
 		}
 	}
+	catch (std::bad_alloc& e) {
+		rows.clear();
+		throw;
+	}
+	return width;
+}
+
+/**
+	 * @brief Loads the table from a binary snapshot.
+	 * @details The cells come back in typed columns with the results of their formulas, so nothing
+	 * is parsed or evaluated. The dependency graph is not part of the snapshot, it is built by the
+	 * first edit. The size of the table is taken from the cells that were read, so it cannot
+	 * disagree with them. An invalid snapshot leaves the table empty.
+	 * @param filepath The file path of the snapshot.
+	 */
+void Table::loadSnapshot(const std::string& filepath)
+{
+	auto start = std::chrono::steady_clock::now();
+	SnapshotReader in(filepath);
+	bool valid = false;
+	try {
+		valid = this->data.readSnapshot(in);
+	}
+	catch (std::bad_alloc& e) {
+		this->clean();
+	}
+	if (!valid) {
+		std::cout << "Snapshot was invalid\n";
+		this->data.pad(1);
+	}
+	this->maxRows = static_cast<int>(this->data.getRows());
+	this->maxCols = static_cast<int>(this->data.getCols());
+	this->dependencies.clear();
+	this->linked = false;
+	this->widths.assign(this->data.getCols(), static_cast<size_t>(UNKNOWN_WIDTH));
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	double seconds = elapsed.count() > 0 ? elapsed.count() : 1e-9;
+	std::cout << "Loaded " << in.bytes() << " bytes in " << seconds * 1000 << " ms ("
+		<< in.bytes() / seconds / (1024 * 1024) << " MB/s), cells use " << this->data.memoryUsage() << " bytes\n";
+}
+
+/**
+	 * @brief Classifies a single token read from a file.
+	 * @details Nothing is printed, parseCell() runs on the loading threads.
+	 * @param token The token read from the file.
+	 * @param invalid Counts the invalid tokens.
+	 * @return The classified token, an empty string if the token is invalid.
+	 */
+Token Table::parseCell(std::string_view token, size_t& invalid)
+{
+	Token parsed = Confirmer::classify(token);
+	if (parsed.type == INVALID_TOKEN) {
+		invalid++;
+		parsed.type = STRING_TOKEN;
+		parsed.text.clear();
+	}
+	return parsed;
+}
+
+/**
+	 * @brief Cleans up the table by removing all cells.
+	 */
+void Table::clean()
+{
+	this->data.clear();
+	this->dependencies.clear();
+	this->widths.clear();
+	this->linked = false;
 }
 
 /**
 	 * @brief Prints the table to the console.
+	 * @details The width of every column is looked up once, measured only if an edit made the
+	 * cached one unknown. Every row is built in a buffer and written at once, the output is
+	 * flushed after the last row.
 	 */
 void Table::print() const {
-	for (size_t i = 0; i < this->data.size() - 1; i++) {
-		for (size_t j = 0; j < this->data[i].size(); j++) {
-			int maxCol = Confirmer::biggestData(j);
-			int dif = maxCol - data[i][j]->stringify().length();
-			std::cout << "|" << data[i][j]->stringify();
-			for (size_t k = 0; k < dif; k++) {
-				std::cout << " ";
+	char text[Data::FORMAT_BUFFER_SIZE];
+	std::vector<size_t> widths(this->data.getCols());
+	for (size_t j = 0; j < widths.size(); j++) {
+		widths[j] = Confirmer::biggestData(j);
+	}
+	std::string line;
+	for (size_t i = 0; i + 1 < this->data.getRows(); i++) {
+		line.clear();
+		for (size_t j = 0; j < widths.size(); j++) {
+			CellView cell = data.view(i, j);
+			size_t length = cell.format(text, sizeof(text));
+			line += '|';
+			if (length <= sizeof(text)) {
+				line.append(text, length);
+			}
+			else {
+				line += cell.stringify();
+			}
+			if (length < widths[j]) {
+				line.append(widths[j] - length, ' ');
 			}
 		}
-		std::cout << "|" << std::endl;
+		line += "|\n";
+		std::cout.write(line.data(), line.size());
 	}
-	std::cout << "\n";
+	std::cout << "\n" << std::flush;
 }
 
 /**
 	 * @brief Saves the table to the default file path.
+	 * @return `true` if the file was replaced, `false` if it was left as it was.
 	 */
-void Table::save() const
+bool Table::save() const
 {
-	std::ofstream file(this->filepath);
+	return this->write(this->filepath);
+}
+
+/**
+	 * @brief Saves the table to a specified file path.
+	 * @param filePath The file path to save the table to.
+	 * @return `true` if the file was replaced, `false` if it was left as it was.
+	 */
+bool Table::saveAs(const std::string& filepath) const
+{
+	return this->write(filepath);
+}
+
+/**
+	 * @brief Checks whether a file path names a binary snapshot rather than a text table.
+	 * @param filepath The file path.
+	 * @return `true` if the path ends with ".snap", `false` otherwise.
+	 */
+bool Table::isSnapshot(const std::string& filepath)
+{
+	const std::string extension = ".snap";
+	return filepath.size() >= extension.size() && filepath.compare(filepath.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+/**
+	 * @brief Writes the table to a file in large blocks, replacing the file atomically.
+	 * @details Every cell is formatted straight into one reusable buffer, which is written whenever
+	 * it is full and once at the end, no row is flushed on its own. A cell longer than the whole
+	 * buffer is written from its own string. The rows go to a temporary file that is renamed over
+	 * the target once it is on disk, so a crash or a full disk leaves the old file intact. Snapshots
+	 * are written by writeSnapshot().
+	 * @param filepath The file path to write the table to.
+	 * @return `true` if the file was replaced, `false` if it was left as it was.
+	 */
+bool Table::write(const std::string& filepath) const
+{
+	if (isSnapshot(filepath)) {
+		return this->writeSnapshot(filepath);
+	}
+	FileWriter file(filepath);
 	try {
 		if (!file.is_open()) {
 			throw std::ofstream::failure("File didnt open");
@@ -148,55 +319,85 @@ void Table::save() const
 	}
 	catch (const std::ofstream::failure& e) {
 		std::cout << e.what();
+		return false;
 	}
 
-	for (size_t i = 0; i < this->data.size() - 1; i++) {
-		for (size_t j = 0; j < this->data[i].size(); j++) {
-			file << data[i][j]->stringifyFile();
-			if (j != this->data[i].size() - 1) {
-				file << ',';
+	std::vector<char> buffer(WRITE_BUFFER_BYTES);
+	size_t used = 0;
+	auto flush = [&]() {
+		file.write(buffer.data(), used);
+		used = 0;
+	};
+	for (size_t i = 0; i + 1 < this->data.getRows(); i++) {
+		for (size_t j = 0; j < this->data.getCols(); j++) {
+			if (j > 0) {
+				if (used == buffer.size()) {
+					flush();
+				}
+				buffer[used++] = ',';
 			}
+			CellView cell = this->data.view(i, j);
+			size_t length = cell.formatFile(buffer.data() + used, buffer.size() - used);
+			if (length > buffer.size() - used) {
+				flush();
+				length = cell.formatFile(buffer.data(), buffer.size());
+				if (length > buffer.size()) {
+					std::string text = cell.stringifyFile();
+					file.write(text.data(), text.size());
+					length = 0;
+				}
+			}
+			used += length;
+		}
+		if (used == buffer.size()) {
+			flush();
+		}
+		buffer[used++] = '\n';
+	}
+	flush();
+	try {
+		if (!file.commit()) {
+			throw std::ofstream::failure("File didnt save");
 		}
-		file << std::endl;
 	}
-	file.close();
+	catch (const std::ofstream::failure& e) {
+		std::cout << e.what();
+		return false;
+	}
+	return true;
 }
 
 /**
-	 * @brief Saves the table to a specified file path.
-	 * @param filePath The file path to save the table to.
+	 * @brief Writes the table to a binary snapshot.
+	 * @details The snapshot holds the table size and the cells written by CellStore::writeSnapshot(),
+	 * the formulas with their current results. It replaces the file atomically, like a text save.
+	 * @param filepath The file path of the snapshot.
+	 * @return `true` if the file was replaced, `false` if it was left as it was.
 	 */
-void Table::saveAs(const std::string& filepath) const
+bool Table::writeSnapshot(const std::string& filepath) const
 {
-	std::ofstream file(filepath);
+	SnapshotWriter out(filepath);
 	try {
-		if (!file.is_open()) {
+		if (!out.is_open()) {
 			throw std::ofstream::failure("File didnt open");
 		}
 	}
 	catch (const std::ofstream::failure& e) {
 		std::cout << e.what();
+		return false;
 	}
 
-	for (size_t i = 0; i < this->data.size() - 1; i++) {
-		for (size_t j = 0; j < this->data[i].size(); j++) {
-			file << data[i][j]->stringifyFile();
-			if (j != this->data[i].size() - 1) {
-				file << ',';
-			}
+	this->data.writeSnapshot(out);
+	try {
+		if (!out.commit()) {
+			throw std::ofstream::failure("File didnt save");
 		}
-		file << std::endl;
 	}
-	file.close();
-}
-
-/**
-	 * @brief Retrieves the table data.
-	 * @return The table data as a 2D vector of Data pointers.
-	 */
-std::vector<std::vector<Data*>> Table::getTable() const
-{
-	return this->data;
+	catch (const std::ofstream::failure& e) {
+		std::cout << e.what();
+		return false;
+	}
+	return true;
 }
 
 /**
@@ -217,55 +418,272 @@ int Table::getMaxCols() const
 	return this->maxCols;
 }
 
+/**
+	 * @brief Retrieves the length of the longest string representation in a column.
+	 * @details The width is cached, a column is only measured again once an edit made its width unknown.
+	 * @param col The column index.
+	 * @return The length of the longest string representation.
+	 */
+int Table::getColumnWidth(const int col) const
+{
+	if (this->widths.size() != this->data.getCols()) {
+		this->widths.assign(this->data.getCols(), static_cast<size_t>(UNKNOWN_WIDTH));
+	}
+	if (this->widths[col] == UNKNOWN_WIDTH) {
+		this->widths[col] = this->data.width(col);
+	}
+	return static_cast<int>(this->widths[col]);
+}
+
+/**
+	 * @brief Retrieves a cell of the table.
+	 * @details The cell is read straight from the store, nothing else is copied. Formulas read the
+	 * cells they reference this way.
+	 * @param row The row index of the cell.
+	 * @param col The column index of the cell.
+	 * @return The cell, an empty cell if the position is outside of the table.
+	 */
+Cell Table::getCell(const unsigned row, const unsigned col) const
+{
+	if (row >= this->data.getRows() || col >= this->data.getCols()) {
+		Cell empty = {};
+		empty.sval = nullptr;
+		empty.type = STRING;
+		return empty;
+	}
+	return this->data.at(row, col);
+}
+
+/**
+	 * @brief Retrieves a cell of the table through the Data interface.
+	 * @details Only the cell is copied, the view formats and evaluates it like its data class.
+	 * @param row The row index of the cell.
+	 * @param col The column index of the cell.
+	 * @return The view of the cell, of an empty cell if the position is outside of the table.
+	 */
+CellView Table::getView(const unsigned row, const unsigned col) const
+{
+	return CellView(this->getCell(row, col));
+}
+
+/**
+	 * @brief Adds the numbers of a range of the table to an aggregate.
+	 * @param range The range, the part outside of the table is ignored.
+	 * @param total The aggregate to add to.
+	 */
+void Table::aggregate(const CellRange& range, Aggregate& total) const
+{
+	CellRange inside = range;
+	inside.bottom = std::min<long long>(range.bottom, static_cast<long long>(this->data.getRows()) - 1);
+	inside.right = std::min<long long>(range.right, static_cast<long long>(this->data.getCols()) - 1);
+	if (inside.top > inside.bottom || inside.left > inside.right) {
+		return;
+	}
+	this->data.aggregate(inside, total, *this);
+}
+
 /**
 	 * @brief Edits the value of a cell in the table.
+	 * @details The cached width of the column is updated from the lengths of the old and the new value.
 	 * @param row The row index of the cell.
 	 * @param col The column index of the cell.
 	 * @param value The new value for the cell.
 	 */
 void Table::editCell(const unsigned row, const unsigned col, const std::string& data){
-	if (row > this->maxRows || col > this->maxCols) {
+	if (row >= this->data.getRows() || col >= this->data.getCols()) {
 		std::cout << "Wrong courdinates given\n";
 		return;
 	}
-	if (Confirmer::isNum(data)) {
-		delete this->data[row][col];
-		this->data[row][col] = new IntData(std::stoi(data));
-	}
-	else if (Confirmer::isDouble(data)) {
-		delete this->data[row][col];
-		this->data[row][col] = new DoubleData(std::stod(data));
-	}
-	else if (Confirmer::isString(data)) {
-		delete this->data[row][col];
-		this->data[row][col] = new StringData(data);
-	}
-	else if (Confirmer::isFormula1(data)) {
-		delete this->data[row][col];
-		std::vector<int> rows;
-		std::vector<int> cols;
-		std::string op = "";
-		Confirmer::extractData1(data, rows, op, cols);
-		this->data[row][col] = new FormulaData(cols[0], rows[0], cols[1], rows[1], op);
-	}
-	else if (Confirmer::isFormula2(data)) {
-		delete this->data[row][col];
-		double dval1 = 0;
-		double dval2 = 0;
-		std::string op = "";
-		Confirmer::extractData2(data, dval1, op, dval2);
-		this->data[row][col] = new FormulaData(dval1, dval2, op);
-	}
-	else if (Confirmer::isFormula3(data)) {
-		double dval3 = 0;
-		int row1 = 0;
-		int col1 = 0;
-		std::string op = "";
-		bool whosFirst = Confirmer::extractData3(data, dval3, op, row1, col1);
-		this->data[row][col] = new FormulaData(dval3, row1, col1, op, whosFirst);
+	Token token = Confirmer::classify(data);
+	if (token.type == INVALID_TOKEN) {
+		std::cout << "Data type was invalide" << std::endl;
+		return;
+	}
+	size_t before = this->data.view(row, col).format(nullptr, 0);
+	this->data.set(row, col, token);
+	this->recalculate(row, col);
+	this->updateWidth(col, before, this->data.view(row, col).format(nullptr, 0));
+}
+
+/**
+	 * @brief Records the cells read by every formula of the table and evaluates all formulas.
+	 */
+void Table::recalculateAll()
+{
+	this->evaluateLevels(this->linkAll());
+}
+
+/**
+	 * @brief Records the cells read by every formula of the table.
+	 * @details The dependency graph is rebuilt from scratch.
+	 * @return The row and column indices of the formulas, in row-major order.
+	 */
+std::vector<std::pair<unsigned, unsigned>> Table::linkAll()
+{
+	std::vector<std::pair<unsigned, unsigned>> formulas;
+	for (size_t i = 0; i < this->data.getRows(); i++) {
+		for (size_t j = 0; j < this->data.getCols(); j++) {
+			if (this->data.at(i, j).type == FORMULA) {
+				formulas.push_back(std::make_pair(i, j));
+			}
+		}
+	}
+	this->dependencies.clear();
+	this->dependencies.reserve(formulas.size());
+	for (size_t i = 0; i < formulas.size(); i++) {
+		this->link(formulas[i].first, formulas[i].second, *this->data.at(formulas[i].first, formulas[i].second).fval);
+	}
+	this->linked = true;
+	return formulas;
+}
+
+/**
+	 * @brief Records the cells read by a formula of the table.
+	 * @details Ranges are clipped to the table first, cells outside of it can never change.
+	 * @param row The row index of the formula.
+	 * @param col The column index of the formula.
+	 * @param formula The formula.
+	 */
+void Table::link(const unsigned row, const unsigned col, const FormulaData& formula)
+{
+	std::vector<CellRange> ranges = formula.getRanges();
+	std::vector<CellRange> inside;
+	for (size_t i = 0; i < ranges.size(); i++) {
+		ranges[i].bottom = std::min<long long>(ranges[i].bottom, static_cast<long long>(this->data.getRows()) - 1);
+		ranges[i].right = std::min<long long>(ranges[i].right, static_cast<long long>(this->data.getCols()) - 1);
+		if (ranges[i].top <= ranges[i].bottom && ranges[i].left <= ranges[i].right) {
+			inside.push_back(ranges[i]);
+		}
+	}
+	this->dependencies.link(row, col, formula.getReferences(), inside);
+}
+
+/**
+	 * @brief Recomputes the formulas that read a changed cell, directly or through other formulas.
+	 * @details The edges of the cell are updated first. The dependent formulas, and the cell itself
+	 * if it is a formula, are all marked dirty and then evaluated level by level, so every formula
+	 * finds the formulas it reads already recomputed and the rest of the table is not touched.
+	 * The cached widths of the columns holding dependent formulas become unknown. After a snapshot
+	 * was loaded the dependency graph is built here first.
+	 * @param row The row index of the changed cell.
+	 * @param col The column index of the changed cell.
+	 */
+void Table::recalculate(const unsigned row, const unsigned col)
+{
+	if (!this->linked) {
+		this->linkAll();
+	}
+	Cell changed = this->data.at(row, col);
+	if (changed.type == FORMULA) {
+		this->link(row, col, *changed.fval);
+	}
+	else {
+		this->dependencies.unlink(row, col);
+	}
+	std::vector<std::pair<unsigned, unsigned>> order = this->dependencies.dependents(row, col);
+	for (size_t i = 0; i < order.size() && !this->widths.empty(); i++) {
+		this->widths[order[i].second] = UNKNOWN_WIDTH;
+	}
+	if (changed.type == FORMULA) {
+		order.push_back(std::make_pair(row, col));
+	}
+	for (size_t i = 0; i < order.size(); i++) {
+		this->data.at(order[i].first, order[i].second).fval->invalidate();
+	}
+	this->evaluateLevels(order);
+}
+
+/**
+	 * @brief Evaluates dirty formulas level by level, spreading large levels over the worker threads.
+	 * @details The formulas of a level only read cells and formulas that are already evaluated, so
+	 * they can be evaluated in any order and on any thread. Formulas that never become ready are
+	 * searched for cycles, the members of a cycle get a #CYCLE result and the formulas reading
+	 * them are levelled and evaluated again.
+	 * @param formulas The row and column indices of the formulas, the formulas they read must be evaluated or among them.
+	 */
+void Table::evaluateLevels(const std::vector<std::pair<unsigned, unsigned>>& formulas)
+{
+	std::vector<std::pair<unsigned, unsigned>> blocked;
+	std::vector<std::vector<std::pair<unsigned, unsigned>>> levels = this->dependencies.levels(formulas, blocked);
+	for (size_t i = 0; i < levels.size(); i++) {
+		this->evaluateLevel(levels[i]);
+	}
+	if (blocked.empty()) {
+		return;
+	}
+	std::vector<std::pair<unsigned, unsigned>> readers;
+	std::vector<std::pair<unsigned, unsigned>> cycles = this->dependencies.cycles(blocked, readers);
+	for (size_t i = 0; i < cycles.size(); i++) {
+		this->data.at(cycles[i].first, cycles[i].second).fval->markCycle();
+	}
+	blocked.clear();
+	levels = this->dependencies.levels(readers, blocked);
+	for (size_t i = 0; i < levels.size(); i++) {
+		this->evaluateLevel(levels[i]);
+	}
+}
+
+/**
+	 * @brief Evaluates formulas that do not read each other, on all threads if there are enough of them.
+	 * @details Formulas sharing an expression read the same cells, so they are in the same level and
+	 * have the same result. Only the first of them is evaluated, the others adopt its result once
+	 * the whole level is done, which keeps the worker threads from touching the same formula.
+	 * @param level The row and column indices of the formulas.
+	 */
+void Table::evaluateLevel(const std::vector<std::pair<unsigned, unsigned>>& level)
+{
+	std::vector<FormulaData*> distinct;
+	std::vector<std::pair<FormulaData*, const FormulaData*>> copies;
+	std::unordered_map<const Expression*, const FormulaData*> first;
+	distinct.reserve(level.size());
+	for (size_t i = 0; i < level.size(); i++) {
+		FormulaData* formula = this->data.at(level[i].first, level[i].second).fval;
+		if (formula->isShared()) {
+			auto found = first.emplace(formula->getExpression(), formula);
+			if (!found.second) {
+				copies.push_back(std::make_pair(formula, found.first->second));
+				continue;
+			}
+		}
+		distinct.push_back(formula);
+	}
+
+	if (distinct.size() < PARALLEL_LEVEL_FORMULAS) {
+		for (size_t i = 0; i < distinct.size(); i++) {
+			distinct[i]->evaluate(*this);
+		}
 	}
 	else {
-		std::cout << "Data type was invalide" << std::endl;
+		this->workers.run((distinct.size() + FORMULAS_PER_TASK - 1) / FORMULAS_PER_TASK, [&](size_t task) {
+			size_t end = std::min(distinct.size(), (task + 1) * FORMULAS_PER_TASK);
+			for (size_t i = task * FORMULAS_PER_TASK; i < end; i++) {
+				distinct[i]->evaluate(*this);
+			}
+		});
+	}
+	for (size_t i = 0; i < copies.size(); i++) {
+		copies[i].first->adopt(*copies[i].second);
+	}
+}
+
+/**
+	 * @brief Keeps the cached width of a column up to date after one of its cells changed.
+	 * @details A longer value widens the column. A shorter value only makes the width unknown if
+	 * the old value was as long as the column is wide, since another cell may be just as long.
+	 * @param col The column index of the cell.
+	 * @param before The length of the string representation of the old value.
+	 * @param after The length of the string representation of the new value.
+	 */
+void Table::updateWidth(const unsigned col, const size_t before, const size_t after)
+{
+	if (col >= this->widths.size() || this->widths[col] == UNKNOWN_WIDTH) {
+		return;
+	}
+	if (after >= this->widths[col]) {
+		this->widths[col] = after;
+	}
+	else if (before == this->widths[col]) {
+		this->widths[col] = UNKNOWN_WIDTH;
 	}
 }
 
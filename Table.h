@@ -5,13 +5,23 @@
 #include <fstream>
 #include <string>
 #include "Confirmer.h"
+#include "Token.h"
 #include "IntData.h"
 #include "DoubleData.h"
 #include "StringData.h"
 #include "FormulaData.h"
+#include "CellStore.h"
+#include "DependencyGraph.h"
+#include "ThreadPool.h"
 #include "CSVReader.h"
+#include "FileWriter.h"
+#include "SnapshotWriter.h"
+#include "SnapshotReader.h"
 #include<stdexcept>
 #include<exception>
+#include<chrono>
+#include<thread>
+#include<string_view>
 
 /**
  * @class Table
@@ -32,20 +42,23 @@ public:
 
 	/**
 	 * @brief Saves the table to the default file path.
+	 * @return `true` if the file was replaced, `false` if it was left as it was.
 	 */
-	void save() const;
+	bool save() const;
 
 	/**
 	 * @brief Saves the table to a specified file path.
 	 * @param filePath The file path to save the table to.
+	 * @return `true` if the file was replaced, `false` if it was left as it was.
 	 */
-	void saveAs(const std::string& filePath) const;
+	bool saveAs(const std::string& filePath) const;
 
 	/**
-	 * @brief Retrieves the table data.
-	 * @return The table data as a 2D vector of Data pointers.
+	 * @brief Checks whether a file path names a binary snapshot rather than a text table.
+	 * @param filepath The file path.
+	 * @return `true` if the path ends with ".snap", `false` otherwise.
 	 */
-	std::vector<std::vector<Data*>> getTable() const;
+	static bool isSnapshot(const std::string& filepath);
 
 	/**
 	 * @brief Retrieves the maximum number of rows in the table.
@@ -59,6 +72,36 @@ public:
 	 */
 	int getMaxCols() const;
 
+	/**
+	 * @brief Retrieves the length of the longest string representation in a column.
+	 * @param col The column index.
+	 * @return The length of the longest string representation.
+	 */
+	int getColumnWidth(const int col) const;
+
+	/**
+	 * @brief Retrieves a cell of the table.
+	 * @param row The row index of the cell.
+	 * @param col The column index of the cell.
+	 * @return The cell, an empty cell if the position is outside of the table.
+	 */
+	Cell getCell(const unsigned row, const unsigned col) const;
+
+	/**
+	 * @brief Retrieves a cell of the table through the Data interface.
+	 * @param row The row index of the cell.
+	 * @param col The column index of the cell.
+	 * @return The view of the cell, of an empty cell if the position is outside of the table.
+	 */
+	CellView getView(const unsigned row, const unsigned col) const;
+
+	/**
+	 * @brief Adds the numbers of a range of the table to an aggregate.
+	 * @param range The range, the part outside of the table is ignored.
+	 * @param total The aggregate to add to.
+	 */
+	void aggregate(const CellRange& range, Aggregate& total) const;
+
 	/**
 	 * @brief Edits the value of a cell in the table.
 	 * @param row The row index of the cell.
@@ -71,10 +114,122 @@ private:
 	std::string filepath; /**< The file path of the table. */
 	int maxRows; /**< The maximum number of rows in the table. */
 	int maxCols; /**< The maximum number of columns in the table. */
-	std::vector<std::vector<Data*>> data; /**< The data stored in the table. */
+	CellStore data; /**< The data stored in the table. */
+	DependencyGraph dependencies; /**< The cells read by every formula of the table. */
+	ThreadPool workers; /**< The threads evaluating the levels of a recalculation. */
+	mutable std::vector<size_t> widths; /**< The cached width of every column, UNKNOWN_WIDTH where it must be measured again. */
+	bool linked; /**< Whether the dependency graph holds every formula, a loaded snapshot leaves it empty until the first edit. */
+
+	static const size_t PARALLEL_CHUNK_BYTES = 1 << 20; /**< The smallest chunk worth loading on its own thread. */
+	static const bool COLUMNAR_STORAGE = true; /**< Whether loaded tables are stored as typed columns. */
+	static const size_t PARALLEL_LEVEL_FORMULAS = 4096; /**< The smallest level worth evaluating on all threads. */
+	static const size_t FORMULAS_PER_TASK = 256; /**< The number of formulas a thread evaluates per claimed task. */
+	static const size_t WRITE_BUFFER_BYTES = 1 << 20; /**< The size of the buffer a saved table is collected in before it is written. */
+	static const size_t UNKNOWN_WIDTH = static_cast<size_t>(-1); /**< The cached width of a column that is not measured yet. */
+
+	/**
+	 * @brief Loads the table from a file, reading it only once.
+	 * @param filepath The file path to load the table from.
+	 * @note Row count, column count and cell contents are all collected in the same pass
+	 * and the load throughput is reported on the console.
+	 */
+	void load(const std::string& filepath);
+
+	/**
+	 * @brief Loads chunks of the table file in parallel and appends their rows in file order.
+	 * @param chunks The chunks of whole lines of the file.
+	 * @param invalid Receives the number of invalid tokens.
+	 * @return The number of tokens of the widest row.
+	 */
+	size_t loadChunks(const std::vector<std::string_view>& chunks, size_t& invalid);
+
+	/**
+	 * @brief Reads the rows of a reader and converts their tokens into cells.
+	 * @param reader The reader to read from.
+	 * @param last Whether the reader reaches the end of the file.
+	 * @param rows Receives the rows.
+	 * @param invalid Counts the invalid tokens.
+	 * @return The number of tokens of the widest row.
+	 */
+	static size_t readRows(CSVReader& reader, const bool last, CellStore& rows, size_t& invalid);
+
+	/**
+	 * @brief Classifies a single token read from a file.
+	 * @param token The token to classify.
+	 * @param invalid Counts the invalid tokens.
+	 * @return The classified token, an empty string if the token is invalid.
+	 */
+	static Token parseCell(std::string_view token, size_t& invalid);
+
+	/**
+	 * @brief Loads the table from a binary snapshot, without parsing or evaluating anything.
+	 * @param filepath The file path of the snapshot.
+	 */
+	void loadSnapshot(const std::string& filepath);
+
+	/**
+	 * @brief Writes the table to a binary snapshot, replacing the file atomically.
+	 * @param filepath The file path of the snapshot.
+	 * @return `true` if the file was replaced, `false` if it was left as it was.
+	 */
+	bool writeSnapshot(const std::string& filepath) const;
+
+	/**
+	 * @brief Writes the table to a file in large blocks, replacing the file atomically.
+	 * @param filepath The file path to write the table to.
+	 * @return `true` if the file was replaced, `false` if it was left as it was.
+	 */
+	bool write(const std::string& filepath) const;
+
+	/**
+	 * @brief Records the cells read by every formula of the table and evaluates all formulas.
+	 */
+	void recalculateAll();
+
+	/**
+	 * @brief Records the cells read by every formula of the table.
+	 * @return The row and column indices of the formulas.
+	 */
+	std::vector<std::pair<unsigned, unsigned>> linkAll();
+
+	/**
+	 * @brief Records the cells read by a formula of the table.
+	 * @param row The row index of the formula.
+	 * @param col The column index of the formula.
+	 * @param formula The formula.
+	 */
+	void link(const unsigned row, const unsigned col, const FormulaData& formula);
+
+	/**
+	 * @brief Recomputes the formulas that read a changed cell, directly or through other formulas.
+	 * @param row The row index of the changed cell.
+	 * @param col The column index of the changed cell.
+	 */
+	void recalculate(const unsigned row, const unsigned col);
+
+	/**
+	 * @brief Evaluates dirty formulas level by level, spreading large levels over the worker threads.
+	 * @param formulas The row and column indices of the formulas, the formulas they read must be evaluated or among them.
+	 */
+	void evaluateLevels(const std::vector<std::pair<unsigned, unsigned>>& formulas);
+
+	/**
+	 * @brief Evaluates formulas that do not read each other, on all threads if there are enough of them.
+	 * @details Formulas written the same way are evaluated once.
+	 * @param level The row and column indices of the formulas.
+	 */
+	void evaluateLevel(const std::vector<std::pair<unsigned, unsigned>>& level);
+
+	/**
+	 * @brief Keeps the cached width of a column up to date after one of its cells changed.
+	 * @param col The column index of the cell.
+	 * @param before The length of the string representation of the old value.
+	 * @param after The length of the string representation of the new value.
+	 */
+	void updateWidth(const unsigned col, const size_t before, const size_t after);
 
 	/**
-	 * @brief Cleans up the table by deleting all data objects.
+	 * @brief Cleans up the table by removing all cells.
 	 */
 	void clean();
 
@@ -11,17 +11,21 @@ void open() {
 
 /**
  * @brief Saves the table to the default file path and displays a success message.
+ * @note The message is only displayed if the file was saved, a failed save leaves the file as it was.
  */
 void save() {
-    Table::getInstance().save();
-    std::cout << "Table successfuly saved\n";
+    if (Table::getInstance().save()) {
+        std::cout << "Table successfuly saved\n";
+    }
 }
 
 /**
  * @brief Saves the table to a specified file path after validating the file extension.
- * @note This function prompts the user to enter a file path and ensures that the extension is ".txt".
+ * @note This function prompts the user to enter a file path and ensures that the extension is ".txt", or ".snap"
+ * for a binary snapshot.
  * If the file extension is incorrect, the user is prompted to enter a valid file path.
- * After a valid file path is entered, the table is saved to that location, and a success message is displayed.
+ * After a valid file path is entered, the table is saved to that location, and a success message is displayed
+ * if the save succeeded.
  */
 void saveAs() {
     std::cout << "Enter file path to save the file in: ";
@@ -29,13 +33,14 @@ void saveAs() {
     while (true) {
         std::cin >> filepath;
         int size = filepath.size();
-        if (filepath[size - 1] != 't' || filepath[size - 2] != 'x' || filepath[size - 3] != 't') {
+        if ((filepath[size - 1] != 't' || filepath[size - 2] != 'x' || filepath[size - 3] != 't') && !Table::isSnapshot(filepath)) {
             std::cout << "Wrong file extension, enter again\n";
         }
         else break;
     }
-    Table::getInstance().saveAs(filepath);
-    std::cout << "Table successfuly saved\n";
+    if (Table::getInstance().saveAs(filepath)) {
+        std::cout << "Table successfuly saved\n";
+    }
 }
 
 
@@ -0,0 +1,109 @@
+#include "ThreadPool.h"
+
+/**
+ * @brief Constructor for ThreadPool.
+ * @details Starts the workers, they sleep until the first batch.
+ * @param workers The number of worker threads besides the calling thread.
+ */
+ThreadPool::ThreadPool(const unsigned workers) : shares(new Share[workers + 1]), task(nullptr), batch(0), busy(0), stopping(false) {
+	for (unsigned i = 0; i <= workers; i++) {
+		this->shares[i].next = 0;
+		this->shares[i].end = 0;
+	}
+	for (unsigned i = 0; i < workers; i++) {
+		this->workers.emplace_back(&ThreadPool::work, this, i);
+	}
+}
+
+/**
+ * @brief Runs a batch of tasks and waits until all of them are done.
+ * @details A batch with fewer tasks than threads, or a pool without workers, runs on the calling thread alone.
+ * @param tasks The number of tasks.
+ * @param task The task, called once with every index below `tasks`. It must not throw.
+ */
+void ThreadPool::run(const size_t tasks, const std::function<void(size_t)>& task) {
+	unsigned threads = this->size();
+	if (threads == 1 || tasks < threads) {
+		for (size_t i = 0; i < tasks; i++) {
+			task(i);
+		}
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		for (unsigned i = 0; i < threads; i++) {
+			this->shares[i].next = tasks * i / threads;
+			this->shares[i].end = tasks * (i + 1) / threads;
+		}
+		this->task = &task;
+		this->busy = threads - 1;
+		this->batch++;
+	}
+	this->started.notify_all();
+	this->drain(threads - 1);
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->finished.wait(lock, [this]() { return this->busy == 0; });
+	this->task = nullptr;
+}
+
+/**
+ * @brief Retrieves the number of threads running a batch, the calling thread included.
+ * @return The number of threads.
+ */
+unsigned ThreadPool::size() const {
+	return this->workers.size() + 1;
+}
+
+/**
+ * @brief Waits for batches and works on them until the pool is stopped.
+ * @param self The index of the share of the worker.
+ */
+void ThreadPool::work(const unsigned self) {
+	size_t seen = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->started.wait(lock, [&]() { return this->stopping || this->batch != seen; });
+			if (this->stopping) {
+				return;
+			}
+			seen = this->batch;
+		}
+		this->drain(self);
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->busy--;
+		}
+		this->finished.notify_one();
+	}
+}
+
+/**
+ * @brief Runs the tasks of the own share, then the tasks left in the other shares.
+ * @details A task is claimed by advancing the cursor of its share, so every task runs exactly
+ * once no matter how many threads steal from the same share.
+ * @param self The index of the share of the thread.
+ */
+void ThreadPool::drain(const unsigned self) {
+	unsigned threads = this->size();
+	for (unsigned k = 0; k < threads; k++) {
+		Share& share = this->shares[(self + k) % threads];
+		for (size_t i = share.next++; i < share.end; i = share.next++) {
+			(*this->task)(i);
+		}
+	}
+}
+
+/**
+ * @brief Destructor for ThreadPool.
+ */
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->started.notify_all();
+	for (size_t i = 0; i < this->workers.size(); i++) {
+		this->workers[i].join();
+	}
+}
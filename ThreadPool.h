@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <cstddef>
+
+/**
+ * @class ThreadPool
+ * @brief Runs batches of independent tasks on a fixed set of worker threads.
+ *
+ * The workers are started once and sleep between batches. The tasks of a batch are split into
+ * one contiguous share per thread, every thread works through its own share first and then
+ * steals the remaining tasks of the other shares, so a thread that got cheap tasks helps the
+ * ones that got expensive tasks. The calling thread takes part in every batch.
+ */
+class ThreadPool {
+public:
+	/**
+	 * @brief Constructs a ThreadPool object and starts its workers.
+	 * @param workers The number of worker threads besides the calling thread.
+	 */
+	explicit ThreadPool(const unsigned workers);
+
+	ThreadPool(const ThreadPool&) = delete; /**< Disable copy constructor. */
+	ThreadPool& operator=(const ThreadPool&) = delete; /**< Disable assignment operator. */
+
+	/**
+	 * @brief Runs a batch of tasks and waits until all of them are done.
+	 * @param tasks The number of tasks.
+	 * @param task The task, called once with every index below `tasks`. It must not throw.
+	 */
+	void run(const size_t tasks, const std::function<void(size_t)>& task);
+
+	/**
+	 * @brief Retrieves the number of threads running a batch, the calling thread included.
+	 * @return The number of threads.
+	 */
+	unsigned size() const;
+
+	/**
+	 * @brief Destructs the ThreadPool object, stopping and joining its workers.
+	 */
+	~ThreadPool();
+
+private:
+	/**
+	 * @struct Share
+	 * @brief The tasks of a batch assigned to one thread.
+	 */
+	struct Share {
+		std::atomic<size_t> next; /**< The next task of the share that no thread has claimed. */
+		size_t end; /**< The end of the share. */
+	};
+
+	/**
+	 * @brief Waits for batches and works on them until the pool is stopped.
+	 * @param self The index of the share of the worker.
+	 */
+	void work(const unsigned self);
+
+	/**
+	 * @brief Runs the tasks of the own share, then the tasks left in the other shares.
+	 * @param self The index of the share of the thread.
+	 */
+	void drain(const unsigned self);
+
+	std::vector<std::thread> workers; /**< The worker threads. */
+	std::unique_ptr<Share[]> shares; /**< One share per thread, the calling thread has the last one. */
+	const std::function<void(size_t)>* task; /**< The task of the current batch. */
+	std::mutex mutex; /**< Guards the batch state below. */
+	std::condition_variable started; /**< Signals the workers that a batch started or the pool stops. */
+	std::condition_variable finished; /**< Signals the calling thread that a worker is done with the batch. */
+	size_t batch; /**< The number of the current batch. */
+	unsigned busy; /**< The number of workers still working on the current batch. */
+	bool stopping; /**< Whether the workers have to exit. */
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Instruction.h"
+
+/**
+ * @enum TokenType
+ * @brief Represents what a token of a table describes.
+ */
+enum TokenType {
+    INT_TOKEN, /**< An integer number. */
+    DOUBLE_TOKEN, /**< A double number. */
+    STRING_TOKEN, /**< A string, empty or in double quotes. */
+    FORMULA_TOKEN, /**< A formula, "=" followed by an expression like "(R1C1+2)*SUM(R0C1:R9C1)". */
+    INVALID_TOKEN /**< Anything else. */
+};
+
+/**
+ * @struct Token
+ * @brief A classified token together with the values parsed from it.
+ */
+struct Token {
+    TokenType type = INVALID_TOKEN; /**< What the token describes. */
+    int ival = 0; /**< The value of an integer token. */
+    double dval = 0; /**< The value of a double token. */
+    std::string text; /**< The value of a string token. */
+    std::vector<Instruction> code; /**< The compiled expression of a formula token. */
+};
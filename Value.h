@@ -0,0 +1,22 @@
+#pragma once
+
+/**
+ * @enum ValueType
+ * @brief Represents the possible types of a computed value.
+ */
+enum ValueType {
+	INT_VALUE, /**< An integer number. */
+	DOUBLE_VALUE, /**< A double number. */
+	ERROR_VALUE, /**< The computation failed, for example by dividing by zero. */
+	CYCLE_VALUE /**< The formula reads itself, directly or through other formulas. */
+};
+
+/**
+ * @struct Value
+ * @brief The typed result of evaluating a formula.
+ */
+struct Value {
+	ValueType type = INT_VALUE; /**< The type of the value. */
+	int ival = 0; /**< The value of an INT_VALUE. */
+	double dval = 0; /**< The value of a DOUBLE_VALUE. */
+};
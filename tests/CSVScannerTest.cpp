@@ -0,0 +1,127 @@
+#include "../CSVReader.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @file CSVScannerTest.cpp
+ * @brief Checks that CSVReader splits lines exactly like the character by character parser it replaced.
+ *
+ * Every line of the files given on the command line and of a set of generated lines, rich in
+ * commas, quotes, backslashes and spaces and long enough to cross several 32 byte blocks, is
+ * split by both modes of CSVReader and by the reference parser below. Build the test once per
+ * scanner path (see tests/Makefile) to cover AVX2, SSE2 and the scalar loop.
+ */
+
+/**
+ * @brief Splits a line the way CSVReader::get_tokens did before CSVScanner.
+ * @param line The line to split, without its terminating newline.
+ * @return The tokens of the line.
+ */
+static std::vector<std::string> referenceTokens(const std::string& line) {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < line.size()) {
+        std::string token = "";
+        bool inText = false;
+        while (i < line.size() && line[i] != ',') {
+            if (inText || line[i] != ' ') {
+                token += line[i];
+            }
+            if ((line[i] == '"' && i == 0) || (line[i] == '"' && line[i - 1] != '\\')) {
+                inText = !inText;
+            }
+            i++;
+        }
+        tokens.push_back(token);
+        i++;
+    }
+    return tokens;
+}
+
+/**
+ * @brief Generates lines made mostly of the characters the scanner looks for.
+ * @param count The number of lines.
+ * @return The generated lines.
+ */
+static std::vector<std::string> generateLines(const size_t count) {
+    static const char ALPHABET[] = ",,,\"\"\"   \\\\ab1.=R";
+    std::mt19937 random(12345);
+    std::vector<std::string> lines(count);
+    for (size_t i = 0; i < count; i++) {
+        size_t length = random() % 200;
+        for (size_t j = 0; j < length; j++) {
+            lines[i] += ALPHABET[random() % (sizeof(ALPHABET) - 1)];
+        }
+    }
+    return lines;
+}
+
+/**
+ * @brief Reads the lines of a file like std::getline does.
+ * @param filename The name of the file.
+ * @param lines Receives the lines.
+ * @return `true` if the file was read, `false` otherwise.
+ */
+static bool readLines(const std::string& filename, std::vector<std::string>& lines) {
+    std::ifstream in(filename, std::ios::binary);
+    std::string line;
+    while (std::getline(in, line)) {
+        lines.push_back(line);
+    }
+    return in.eof();
+}
+
+/**
+ * @brief Splits a set of lines with both modes of CSVReader and compares them with the reference.
+ * @param name The name of the set, for the report.
+ * @param lines The lines to split.
+ * @return The number of lines split differently.
+ */
+static size_t check(const std::string& name, const std::vector<std::string>& lines) {
+    std::string text;
+    for (const std::string& line : lines) {
+        text += line;
+        text += '\n';
+    }
+    const std::string path = "CSVScannerTest.tmp";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << text;
+    }
+    CSVReader stream(path, 0);
+    CSVReader mapped(std::string_view(text), 0);
+    size_t failures = 0;
+    for (size_t i = 0; i < lines.size(); i++) {
+        std::vector<std::string> expected = referenceTokens(lines[i]);
+        std::vector<std::string> streamed = stream.get_tokens();
+        const std::vector<std::string_view>& views = mapped.get_token_views();
+        std::vector<std::string> viewed(views.begin(), views.end());
+        if (streamed != expected || viewed != expected) {
+            if (failures++ < 5) {
+                std::cout << name << " line " << i + 1 << " split differently: " << lines[i] << "\n";
+            }
+        }
+    }
+    std::remove(path.c_str());
+    std::cout << name << ": " << lines.size() << " lines, " << failures << " different\n";
+    return failures;
+}
+
+int main(int argc, char* argv[]) {
+    size_t failures = check("generated", generateLines(20000));
+    for (int i = 1; i < argc; i++) {
+        std::vector<std::string> lines;
+        if (!readLines(argv[i], lines)) {
+            std::cout << argv[i] << ": could not be read\n";
+            failures++;
+            continue;
+        }
+        failures += check(argv[i], lines);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+#include "../Confirmer.h"
+#include "../ExpressionPool.h"
+#include "../FormulaData.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @file FormulaSaveTest.cpp
+ * @brief Checks that formulas written for file output read back as the same formulas.
+ *
+ * Every formula is classified like a token of a loaded file, written by FormulaData::stringifyFile()
+ * and classified again. Both readings must intern to the same expression, and writing the second
+ * one must give the same text. The long chains nest their left operands as deep as they are long,
+ * they fail with a stack overflow if the writer recurses.
+ */
+
+/**
+ * @brief Builds a chain of operands joined by the same operators.
+ * @param terms The number of operands.
+ * @param joiner The text between two operands.
+ * @param operand The text of every operand.
+ * @return The formula, with its leading '='.
+ */
+static std::string chain(const size_t terms, const std::string& joiner, const std::string& operand) {
+    std::string formula = "=" + operand;
+    for (size_t i = 1; i < terms; i++) {
+        formula += joiner;
+        formula += operand;
+    }
+    return formula;
+}
+
+/**
+ * @brief Writes a formula for file output and reads it back.
+ * @param pool The pool the expressions are interned in.
+ * @param name The name of the formula, for the report.
+ * @param formula The formula, as it appears in a file.
+ * @return `true` if the formula read back unchanged, `false` otherwise.
+ */
+static bool roundTrip(ExpressionPool& pool, const std::string& name, const std::string& formula) {
+    const int row = 3;
+    const int col = 2;
+    Token token = Confirmer::classify(formula);
+    if (token.type != FORMULA_TOKEN) {
+        std::cout << name << ": not a formula\n";
+        return false;
+    }
+    FormulaData::makeRelative(token.code, row, col);
+    const Expression* expression = pool.intern(std::move(token.code));
+    std::string text = FormulaData(expression, row, col).stringifyFile();
+    Token reread = Confirmer::classify(text);
+    bool same = reread.type == FORMULA_TOKEN;
+    if (same) {
+        FormulaData::makeRelative(reread.code, row, col);
+        const Expression* second = pool.intern(std::move(reread.code));
+        same = second == expression && FormulaData(second, row, col).stringifyFile() == text;
+        pool.release(second);
+    }
+    pool.release(expression);
+    std::cout << name << ": " << formula.size() << " characters written as " << text.size()
+        << (same ? ", read back unchanged\n" : ", read back differently\n");
+    return same;
+}
+
+int main() {
+    ExpressionPool pool;
+    size_t failures = 0;
+    failures += !roundTrip(pool, "mixed", "=-(R1C1 - 2) * (R2C1 + R3C1 / 4) - SUM(R1C1:R4C2) > -R1C2");
+    failures += !roundTrip(pool, "short chain", chain(8, " + ", "R1C1"));
+    failures += !roundTrip(pool, "sum chain", chain(100000, " + ", "R1C1"));
+    failures += !roundTrip(pool, "difference chain", chain(100000, " - ", "2.5"));
+    failures += !roundTrip(pool, "product chain", chain(50000, " * ", "(R1C1 + 1)"));
+    failures += !roundTrip(pool, "aggregate chain", chain(50000, " / ", "-AVG(R1C1:R2C2)"));
+    return failures == 0 ? 0 : 1;
+}